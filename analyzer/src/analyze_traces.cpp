@@ -0,0 +1,494 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Analysis of saved traces
+ *
+ ******************************************************************************/
+
+/* Runs the accumulators of a campaign on the traces and labels saved with -s,
+   without simulating again (e.g. another order, another window or another
+   split of the classes). The files are memory-mapped and the rows are split
+   into one contiguous shard per thread, each thread with its own
+   accumulators. The accumulators are merged in the order of the shards, so
+   the results only depend on the number of threads through the rounding of
+   the higher orders */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <thread>
+#include <getopt.h>
+#include "npy.h"
+#include "options.h"
+#include "power_sum.h"
+#include "moment_ttest.h"
+#include "histogram_test.h"
+#include "bivariate_ttest.h"
+#include "sparse_result.h"
+#include "utils.h"
+
+/* traces of a class buffered before the batch update of the accumulators */
+#define BATCH_TRACES 64
+/* rows read between two releases of their pages */
+#define RELEASE_ROWS 4096
+/* threshold of the sparse t-tests without -e */
+#define SPARSE_THRESHOLD 4.5
+
+typedef struct
+{
+	std::string t_test_filename;
+	unsigned int n_thread;
+	unsigned int t_test_order;
+	bool with_histogram;
+	unsigned int bivariate_window;
+	std::vector<unsigned int> poi;
+	unsigned int label[2];                /* labels of the two classes */
+	unsigned long int first_sample;
+	unsigned long int last_sample;        /* 0: end of the traces */
+	unsigned int sparse_buckets;
+	double threshold;
+} Analysis;
+
+/* accumulators of one shard of the rows */
+class Shard
+{
+	private:
+		const Analysis &analysis;
+		unsigned int n_sample;
+		std::vector<uint8_t> batch[2];
+		unsigned int n_batch[2];
+		std::vector<unsigned int> vec;
+		std::vector<unsigned int> poi_trace;
+
+		void flush(unsigned int cls);
+
+	public:
+		Power_sum_ttest ttest;
+		Moment_ttest *moment_ttest_ptr;
+		Histogram_test *histogram_test_ptr;
+		Bivariate_ttest *bivariate_ttest_ptr;
+		unsigned long int n_other;         /* rows of another label */
+
+		Shard(const Analysis &analysis, unsigned int n_sample);
+		~Shard();
+		void run(const Npy_reader &traces, const Npy_reader &labels, unsigned long int first_row, unsigned long int last_row);
+		void merge(const Shard &other);
+};
+
+Shard::Shard(const Analysis &analysis, unsigned int n_sample) :
+	analysis(analysis), ttest(n_sample)
+{
+	this->n_sample = n_sample;
+	this->n_other = 0;
+	this->moment_ttest_ptr = nullptr;
+	this->histogram_test_ptr = nullptr;
+	this->bivariate_ttest_ptr = nullptr;
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->batch[cls].resize(BATCH_TRACES*n_sample);
+		this->n_batch[cls] = 0;
+	}
+	if (analysis.t_test_order > 1)
+	{
+		this->moment_ttest_ptr = new Moment_ttest(n_sample, analysis.t_test_order);
+	}
+	if (analysis.with_histogram)
+	{
+		/* empty bins do not count in the chi-square test */
+		this->histogram_test_ptr = new Histogram_test(n_sample, 256);
+	}
+	if (analysis.bivariate_window > 0)
+	{
+		this->bivariate_ttest_ptr = new Bivariate_ttest(n_sample, analysis.bivariate_window);
+	}
+	else if (analysis.poi.size() > 0)
+	{
+		this->poi_trace.resize(analysis.poi.size());
+		this->bivariate_ttest_ptr = new Bivariate_ttest(analysis.poi.size(), analysis.poi.size() - 1);
+	}
+}
+
+Shard::~Shard()
+{
+	delete this->moment_ttest_ptr;
+	delete this->histogram_test_ptr;
+	delete this->bivariate_ttest_ptr;
+}
+
+void Shard::flush(unsigned int cls)
+{
+	const uint8_t *rows = this->batch[cls].data();
+
+	if (this->n_batch[cls] == 0)
+	{
+		return;
+	}
+	if (cls == 0)
+	{
+		this->ttest.update1_batch(rows, this->n_batch[cls]);
+	}
+	else
+	{
+		this->ttest.update2_batch(rows, this->n_batch[cls]);
+	}
+	if (this->moment_ttest_ptr != nullptr)
+	{
+		if (cls == 0)
+		{
+			this->moment_ttest_ptr->update1_batch(rows, this->n_batch[cls]);
+		}
+		else
+		{
+			this->moment_ttest_ptr->update2_batch(rows, this->n_batch[cls]);
+		}
+	}
+	if (this->histogram_test_ptr != nullptr)
+	{
+		if (cls == 0)
+		{
+			this->histogram_test_ptr->update1_batch(rows, this->n_batch[cls]);
+		}
+		else
+		{
+			this->histogram_test_ptr->update2_batch(rows, this->n_batch[cls]);
+		}
+	}
+	this->n_batch[cls] = 0;
+}
+
+/* rows [first_row, last_row), the samples of the analysis window only */
+void Shard::run(const Npy_reader &traces, const Npy_reader &labels, unsigned long int first_row, unsigned long int last_row)
+{
+	unsigned long int released = first_row;
+
+	for (unsigned long int r = first_row; r < last_row; ++r)
+	{
+		uint8_t label = *static_cast<const uint8_t *>(labels.row(r));
+		unsigned int cls = (label == this->analysis.label[0]) ? 0 : 1;
+		if (label != this->analysis.label[0] && label != this->analysis.label[1])
+		{
+			this->n_other++;
+			continue;
+		}
+		const uint8_t *x = static_cast<const uint8_t *>(traces.row(r)) + this->analysis.first_sample;
+		memcpy(this->batch[cls].data() + this->n_batch[cls]*this->n_sample, x, this->n_sample);
+		if (++this->n_batch[cls] == BATCH_TRACES)
+		{
+			this->flush(cls);
+		}
+		if (this->bivariate_ttest_ptr != nullptr)
+		{
+			std::vector<unsigned int> *vec = &this->vec;
+			if (this->poi_trace.size() > 0)
+			{
+				for (unsigned int k = 0; k < this->poi_trace.size(); ++k)
+				{
+					this->poi_trace[k] = x[this->analysis.poi[k]];
+				}
+				vec = &this->poi_trace;
+			}
+			else
+			{
+				this->vec.assign(x, x + this->n_sample);
+			}
+			if (cls == 0)
+			{
+				this->bivariate_ttest_ptr->update1(*vec);
+			}
+			else
+			{
+				this->bivariate_ttest_ptr->update2(*vec);
+			}
+		}
+		if (r + 1 - released >= RELEASE_ROWS)
+		{
+			traces.release(released, r + 1);
+			released = r + 1;
+		}
+	}
+	this->flush(0);
+	this->flush(1);
+	traces.release(released, last_row);
+}
+
+void Shard::merge(const Shard &other)
+{
+	this->ttest.merge(other.ttest);
+	if (this->moment_ttest_ptr != nullptr)
+	{
+		this->moment_ttest_ptr->merge(*other.moment_ttest_ptr);
+	}
+	if (this->histogram_test_ptr != nullptr)
+	{
+		this->histogram_test_ptr->merge(*other.histogram_test_ptr);
+	}
+	if (this->bivariate_ttest_ptr != nullptr)
+	{
+		this->bivariate_ttest_ptr->merge(*other.bivariate_ttest_ptr);
+	}
+	this->n_other += other.n_other;
+}
+
+/* name of an additional result file: t_test.npy -> t_test_<suffix><extension> */
+static std::string output_filename(const Analysis &analysis, std::string suffix, std::string extension = ".npy")
+{
+	std::string base = analysis.t_test_filename;
+	std::string::size_type pos = base.rfind(".npy");
+
+	if (pos != std::string::npos && pos == base.length() - 4)
+	{
+		base.erase(pos);
+	}
+	return base + "_" + suffix + extension;
+}
+
+static void save_results(const Analysis &analysis, Shard &shard)
+{
+	std::vector<double> t = shard.ttest.t_test();
+	double max = 0.0;
+
+	for (auto x : t)
+	{
+		max = (fabs(x) > max) ? fabs(x) : max;
+	}
+	printf("-- %lu + %lu traces, %lu samples, max |t| %.2f\n", shard.ttest.get_count(0), shard.ttest.get_count(1),
+		static_cast<unsigned long int>(t.size()), max);
+	save_npy(analysis.t_test_filename, t);
+	if (analysis.sparse_buckets > 0)
+	{
+		save_sparse_ttest(output_filename(analysis, "sparse", ".json"), output_filename(analysis, "envelope"), t,
+			analysis.threshold, analysis.sparse_buckets, {}, {});
+	}
+	for (unsigned int order = 2; order <= analysis.t_test_order; ++order)
+	{
+		std::string suffix = "order" + std::to_string(order);
+		std::vector<double> t_order = shard.moment_ttest_ptr->t_test(order);
+		save_npy(output_filename(analysis, suffix), t_order);
+		if (analysis.sparse_buckets > 0)
+		{
+			save_sparse_ttest(output_filename(analysis, suffix + "_sparse", ".json"), output_filename(analysis, suffix + "_envelope"),
+				t_order, analysis.threshold, analysis.sparse_buckets, {}, {});
+		}
+	}
+	if (shard.histogram_test_ptr != nullptr)
+	{
+		save_npy(output_filename(analysis, "chi2"), shard.histogram_test_ptr->chi2_test());
+	}
+	if (shard.bivariate_ttest_ptr != nullptr)
+	{
+		std::vector<double> t_bivariate = shard.bivariate_ttest_ptr->t_test();
+		unsigned int n_col = shard.bivariate_ttest_ptr->get_window();
+		if (analysis.poi.size() > 0)
+		{
+			unsigned int n_poi = analysis.poi.size();
+			std::vector<double> t_map(n_poi*n_poi, 0.0);
+			for (unsigned int a = 0; a < n_poi; ++a)
+			{
+				for (unsigned int b = a + 1; b < n_poi; ++b)
+				{
+					t_map[a*n_poi + b] = t_bivariate[a*n_col + b - a - 1];
+					t_map[b*n_poi + a] = t_bivariate[a*n_col + b - a - 1];
+				}
+			}
+			t_bivariate.swap(t_map);
+			n_col = n_poi;
+		}
+		save_npy(output_filename(analysis, "bivariate"), t_bivariate, n_col);
+	}
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "%s [-o <filename>] [-j <n_thread>] [-d <order>] [-H] [-W <window> | -P <poi>] [-l <label>,<label>] [-w <first>,<last>] [-z <n_bucket>] [-e <threshold>] <traces.npy> <labels.npy>\n", name);
+	fprintf(stderr, "\tanalyze the traces and labels saved by a simulator with -s\n");
+	fprintf(stderr, "\t-o: name of .npy file. Default to 't_test.npy'\n");
+	fprintf(stderr, "\t-j: number of threads, each analyzing a contiguous shard of the traces. Default to 1\n");
+	fprintf(stderr, "\t-d: also run the univariate t-test at orders 2 to <order>. Default to 1\n");
+	fprintf(stderr, "\t-H: also run the chi-square test on the histograms of the samples (any order, -log10 p-values)\n");
+	fprintf(stderr, "\t-W: bivariate t-test on all sample pairs at most <window> samples apart\n");
+	fprintf(stderr, "\t-P: bivariate t-test on all pairs of the comma separated sample indices (in the window of -w)\n");
+	fprintf(stderr, "\t-l: labels of the two classes, e.g. 0,2 for fixed-vs-fixed with -x. Default to 0,1 (fixed vs random)\n");
+	fprintf(stderr, "\t-w: analyze the samples <first> to <last> - 1 only\n");
+	fprintf(stderr, "\t-z: also write the sparse t-tests: max |t| and the samples over the threshold, and a min/max envelope of <n_bucket> buckets\n");
+	fprintf(stderr, "\t-e: threshold of the sparse t-tests. Default to 4.5\n");
+}
+
+int main(int argc, char *argv[])
+{
+	Analysis analysis = {"t_test.npy", 1, 1, false, 0, {}, {0, 1}, 0, 0, 0, SPARSE_THRESHOLD};
+	std::vector<unsigned int> list;
+	int c;
+
+	while ((c = getopt(argc, argv, "o:j:d:HW:P:l:w:z:e:")) != -1)
+	{
+		switch (c)
+		{
+			case 'o':
+				analysis.t_test_filename = optarg;
+				break;
+			case 'j':
+				analysis.n_thread = strtoul(optarg, NULL, 0);
+				break;
+			case 'd':
+				analysis.t_test_order = strtoul(optarg, NULL, 0);
+				break;
+			case 'H':
+				analysis.with_histogram = true;
+				break;
+			case 'W':
+				analysis.bivariate_window = strtoul(optarg, NULL, 0);
+				break;
+			case 'P':
+				analysis.poi = parse_uint_list(optarg);
+				break;
+			case 'l':
+				list = parse_uint_list(optarg);
+				if (list.size() != 2 || list[0] == list[1] || list[0] > 255 || list[1] > 255)
+				{
+					fprintf(stderr, "ERROR: -l <label>,<label> must give two different labels\n");
+					std::exit(EXIT_FAILURE);
+				}
+				analysis.label[0] = list[0];
+				analysis.label[1] = list[1];
+				break;
+			case 'w':
+				list = parse_uint_list(optarg);
+				if (list.size() != 2 || list[0] >= list[1])
+				{
+					fprintf(stderr, "ERROR: -w <first>,<last> must give a non-empty range of samples\n");
+					std::exit(EXIT_FAILURE);
+				}
+				analysis.first_sample = list[0];
+				analysis.last_sample = list[1];
+				break;
+			case 'z':
+				analysis.sparse_buckets = strtoul(optarg, NULL, 0);
+				break;
+			case 'e':
+				analysis.threshold = strtod(optarg, NULL);
+				break;
+			default:
+				usage(argv[0]);
+				std::exit(EXIT_FAILURE);
+		}
+	}
+	if (argc - optind != 2)
+	{
+		usage(argv[0]);
+		std::exit(EXIT_FAILURE);
+	}
+	if (analysis.n_thread < 1)
+	{
+		fprintf(stderr, "ERROR: -j <n_thread> must be at least 1\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (analysis.t_test_order < 1 || analysis.t_test_order > MAX_T_TEST_ORDER)
+	{
+		fprintf(stderr, "ERROR: -d <order> must be between 1 and %u\n", MAX_T_TEST_ORDER);
+		std::exit(EXIT_FAILURE);
+	}
+	if (analysis.bivariate_window > 0 && analysis.poi.size() > 0)
+	{
+		fprintf(stderr, "ERROR: -W and -P can not be combined\n");
+		std::exit(EXIT_FAILURE);
+	}
+
+	Npy_reader traces(argv[optind]);
+	Npy_reader labels(argv[optind + 1]);
+	if (traces.get_descr() != "|u1" || labels.get_descr() != "|u1" || labels.get_n_col() != 1)
+	{
+		fprintf(stderr, "ERROR: traces and labels must be 8-bit, as saved with -s\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (labels.get_n_row() != traces.get_n_row())
+	{
+		fprintf(stderr, "ERROR: %lu traces and %lu labels\n", traces.get_n_row(), labels.get_n_row());
+		std::exit(EXIT_FAILURE);
+	}
+	if (analysis.last_sample == 0)
+	{
+		analysis.last_sample = traces.get_n_col();
+	}
+	if (analysis.last_sample > traces.get_n_col())
+	{
+		fprintf(stderr, "ERROR: -w: the traces have %lu samples\n", traces.get_n_col());
+		std::exit(EXIT_FAILURE);
+	}
+	unsigned int n_sample = analysis.last_sample - analysis.first_sample;
+	if (analysis.bivariate_window >= n_sample)
+	{
+		fprintf(stderr, "ERROR: -W <window> must be less than the number of samples (%u)\n", n_sample);
+		std::exit(EXIT_FAILURE);
+	}
+	if (analysis.poi.size() == 1)
+	{
+		fprintf(stderr, "ERROR: -P <poi> needs at least 2 samples\n");
+		std::exit(EXIT_FAILURE);
+	}
+	for (auto i : analysis.poi)
+	{
+		if (i >= n_sample)
+		{
+			fprintf(stderr, "ERROR: -P: sample %u is out of the %u samples\n", i, n_sample);
+			std::exit(EXIT_FAILURE);
+		}
+	}
+
+	/* shard k has the rows [k*n_row/n_thread, (k + 1)*n_row/n_thread) */
+	unsigned long int n_row = traces.get_n_row();
+	std::vector<Shard *> shards;
+	std::vector<std::thread> threads;
+	for (unsigned int k = 0; k < analysis.n_thread; ++k)
+	{
+		shards.push_back(new Shard(analysis, n_sample));
+	}
+	for (unsigned int k = 1; k < analysis.n_thread; ++k)
+	{
+		threads.push_back(std::thread(&Shard::run, shards[k], std::cref(traces), std::cref(labels),
+			n_row*k/analysis.n_thread, n_row*(k + 1)/analysis.n_thread));
+	}
+	shards[0]->run(traces, labels, 0, n_row/analysis.n_thread);
+	for (unsigned int k = 1; k < analysis.n_thread; ++k)
+	{
+		threads[k - 1].join();
+		shards[0]->merge(*shards[k]);
+		delete shards[k];
+	}
+	if (shards[0]->n_other > 0)
+	{
+		printf("-- %lu traces of other labels skipped\n", shards[0]->n_other);
+	}
+	save_results(analysis, *shards[0]);
+	delete shards[0];
+
+	return 0;
+}
@@ -0,0 +1,67 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * One-way ANOVA F-test
+ *
+ ******************************************************************************/
+
+#ifndef __ANOVA_H__
+#define __ANOVA_H__
+
+#include <cstdint>
+#include <vector>
+#include "state_file.h"
+
+/* Per-sample one-way analysis of variance of the traces partitioned into
+   n_class classes (e.g. values of an intermediate). With 8-bit samples the
+   class sums and the sum of squares are exact integers:
+   SSB = sum_c s_c^2/n_c - s^2/n and SSW = sum x^2 - sum_c s_c^2/n_c */
+class Anova
+{
+	private:
+		unsigned int n_sample;
+		unsigned int n_class;
+		unsigned long int n;
+		std::vector<uint64_t> n_c;         /* per class */
+		std::vector<uint64_t> s;           /* sum of x at c*n_sample + i */
+		std::vector<uint64_t> s2;          /* sum of x^2, per sample */
+
+	public:
+		Anova(unsigned int n_sample, unsigned int n_class);
+		~Anova();
+		void reset(void);
+		void update(const std::vector<unsigned int> &vec, unsigned int cls);
+		std::vector<double> f_test(void) const;
+		unsigned int get_n_class_seen(void) const;
+		unsigned long int get_n(void) const;
+		void merge(const Anova &other);
+		void save(State_writer &writer);
+		void load(State_reader &reader);
+};
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Correlation power analysis
+ *
+ ******************************************************************************/
+
+#ifndef __CPA_H__
+#define __CPA_H__
+
+#include <cstdint>
+#include <vector>
+#include "state_file.h"
+
+/* Online Pearson correlation between each sample x_i and the hypothetical
+   leakage h_g of each key guess. Samples and hypotheses are 8-bit integers,
+   so the sums of x, x^2, h, h^2 and of the cross-products x*h are exact.
+   Traces are buffered by batches: the cross-products of a batch are the
+   product H^T X of the (batch x n_guess) hypotheses by the (batch x n_sample)
+   traces, computed by tiles into 32-bit sums that are flushed to 64-bit sums
+   before they can overflow */
+class Cpa
+{
+	private:
+		unsigned int n_sample;
+		unsigned int n_guess;
+		unsigned long int n;
+		std::vector<uint64_t> sx;          /* per sample */
+		std::vector<uint64_t> sx2;
+		std::vector<uint64_t> sh;          /* per guess */
+		std::vector<uint64_t> sh2;
+		std::vector<uint64_t> sxh;         /* sum of x_i h_g at g*n_sample + i */
+		std::vector<uint32_t> sxh_32;
+		unsigned int n_pending;            /* traces in sxh_32 */
+		unsigned int n_batch;              /* traces in the batch */
+		std::vector<uint32_t> batch_x;
+		std::vector<uint32_t> batch_h;
+
+		void flush_batch(void);
+		void flush(void);
+
+	public:
+		Cpa(unsigned int n_sample, unsigned int n_guess);
+		~Cpa();
+		void reset(void);
+		unsigned int get_n_sample(void) const;
+		unsigned int get_n_guess(void) const;
+		void update(const std::vector<unsigned int> &trace, const std::vector<unsigned int> &h);
+		std::vector<double> correlation(void);
+		unsigned int rank(const std::vector<double> &correlation, unsigned int guess) const;
+		void merge(const Cpa &other);
+		void save(State_writer &writer);
+		void load(State_reader &reader);
+};
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Histogram chi-square test
+ *
+ ******************************************************************************/
+
+#ifndef __HISTOGRAM_TEST_H__
+#define __HISTOGRAM_TEST_H__
+
+#include <cstdint>
+#include <vector>
+#include "state_file.h"
+#include "sample_pool.h"
+
+/* Samples take few values (0 to 32 for Hamming weights/distances, 0 to 255
+   for ADC codes), so the histogram of a sample in each class holds its whole
+   distribution and is updated with one increment. The chi-square test of
+   independence between the class and the sample value detects a difference
+   at any order. Histograms are kept in 32-bit counters, flushed to 64-bit
+   counters before they overflow. The 64-bit counters are only allocated by
+   the first flush, merge or load. Batches of traces (update1_batch(),
+   update2_batch()) are accumulated by blocks of samples, split among the
+   threads of a Sample_pool if given. A row of a batch can stand for several
+   identical traces (weight) */
+class Histogram_test
+{
+	private:
+		unsigned int n_sample;
+		unsigned int n_bin;
+		unsigned long int n[2];
+		unsigned long int n_pending[2];
+		std::vector<uint32_t> counts[2];
+		std::vector<uint64_t> totals[2];   /* empty until the first flush */
+
+		void update(unsigned int cls, const std::vector<unsigned int> &vec);
+		void add_batch(unsigned int cls, const uint8_t *batch, unsigned int n_trace, const unsigned int *weight,
+			unsigned int i_first, unsigned int i_last);
+		void update_batch(unsigned int cls, const uint8_t *batch, unsigned int n_trace, const unsigned int *weight,
+			Sample_pool *pool);
+		void flush(unsigned int cls);
+		uint64_t count(unsigned int cls, unsigned long int k) const;
+
+	public:
+		Histogram_test(unsigned int n_sample, unsigned int n_bin);
+		~Histogram_test();
+		void reset(void);
+		void update1(const std::vector<unsigned int> &vec);
+		void update2(const std::vector<unsigned int> &vec);
+		void update1_batch(const uint8_t *batch, unsigned int n_trace, const unsigned int *weight = nullptr,
+			Sample_pool *pool = nullptr);
+		void update2_batch(const uint8_t *batch, unsigned int n_trace, const unsigned int *weight = nullptr,
+			Sample_pool *pool = nullptr);
+		void merge(const Histogram_test &other);
+		void save(State_writer &writer);
+		void load(State_reader &reader);
+		std::vector<double> chi2_test(void);
+};
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Higher-order univariate t-test
+ *
+ ******************************************************************************/
+
+#ifndef __MOMENT_TTEST_H__
+#define __MOMENT_TTEST_H__
+
+#include <cstdint>
+#include <vector>
+#include "state_file.h"
+#include "sample_pool.h"
+
+/* One-pass, numerically stable accumulation of the mean and of the central
+   sums CS_p = sum (x - mean)^p, p = 2..2*max_order, per sample and per class
+   (Schneider and Moradi, "Leakage Assessment Methodology", CHES 2015).
+   t_test(d) is the Welch t-test at order d:
+     d = 1: on x
+     d = 2: on (x - mean)^2
+     d > 2: on ((x - mean)/std)^d
+   Batches of traces (update1_batch(), update2_batch()) are accumulated by
+   blocks of samples, split among the threads of a Sample_pool if given, with
+   the same result as trace by trace. A row of a batch can stand for several
+   identical traces (weight) */
+class Moment_ttest
+{
+	private:
+		unsigned int n_sample;
+		unsigned int max_order;
+		unsigned int n_cs;                 /* number of central sums per sample */
+		unsigned long int n[2];
+		std::vector<double> mean[2];
+		std::vector<double> cs[2];         /* CS_p of sample i at i*n_cs + p - 2 */
+		std::vector<double> binomial;      /* C(p, k) at p*(n_cs + 2) + k */
+
+		void init_binomial(void);
+		void init_factor(double count, double weight, double *factor) const;
+		void update_sample(unsigned int cls, unsigned int i, double x, double count, double weight, const double *factor);
+		void update(unsigned int cls, const std::vector<unsigned int> &vec);
+		void add_batch(unsigned int cls, const uint8_t *batch, unsigned int n_trace, const unsigned int *weight,
+			const double *count, const double *factor, unsigned int i_first, unsigned int i_last);
+		void update_batch(unsigned int cls, const uint8_t *batch, unsigned int n_trace, const unsigned int *weight,
+			Sample_pool *pool);
+		double central_moment(unsigned int cls, unsigned int i, unsigned int p) const;
+
+	public:
+		Moment_ttest(unsigned int n_sample, unsigned int max_order);
+		~Moment_ttest();
+		void reset(void);
+		void add_constant_sample(double value);
+		void update1(const std::vector<unsigned int> &vec);
+		void update2(const std::vector<unsigned int> &vec);
+		void update1_batch(const uint8_t *batch, unsigned int n_trace, const unsigned int *weight = nullptr,
+			Sample_pool *pool = nullptr);
+		void update2_batch(const uint8_t *batch, unsigned int n_trace, const unsigned int *weight = nullptr,
+			Sample_pool *pool = nullptr);
+		void expand(const std::vector<unsigned int> &remap, const std::vector<unsigned int> &constant_value);
+		void merge(const Moment_ttest &other);
+		void save(State_writer &writer) const;
+		void load(State_reader &reader);
+		std::vector<double> t_test(unsigned int order);
+};
+
+#endif
@@ -33,7 +33,16 @@
 #ifndef __OPTIONS_H__
 #define __OPTIONS_H__
 
+#include <cstdint>
 #include <string>
+#include <vector>
+
+#define MAX_T_TEST_ORDER 5
+
+/* classes of the ANOVA F-test */
+#define ANOVA_NONE 0
+#define ANOVA_VALUE 1                     /* value of the intermediate */
+#define ANOVA_HW 2                        /* Hamming weight of the intermediate */
 
 typedef struct
 {
@@ -44,6 +53,35 @@ typedef struct
 	unsigned long int n_measure;          /* number of measurements for t-test */
 	bool with_gdb;                        /* true when connected to GDB server */
 	bool with_pipeline_leakage;           /* include leakage from pipeline registers A and B */           
+	double noise_sigma;                   /* std deviation of the measurement noise (0: no noise) */
+	std::vector<double> fir_taps;         /* taps of the scope bandwidth filter (empty: no filter) */
+	unsigned int decimation;              /* keep one sample out of 'decimation' */
+	double adc_gain;                      /* ADC codes per Hamming weight unit */
+	bool with_bit_leakage;                /* also trace and test the leakage of each bit */
+	unsigned long int n_warmup;           /* measurements used to find constant samples (0: keep all samples) */
+	bool with_alignment;                  /* align samples on (PC, occurrence, event) for data dependent control flow */
+	unsigned int t_test_order;            /* highest order of the univariate t-test */
+	unsigned int bivariate_window;        /* max distance of the sample pairs of the bivariate t-test (0: disabled) */
+	std::vector<unsigned int> poi;        /* points of interest of the bivariate t-test (empty: use the window) */
+	std::string state_filename;           /* save the state of the accumulators to this file (empty: not saved) */
+	std::vector<std::string> merge_filenames; /* states of other campaigns merged before computing the results */
+	unsigned long int checkpoint_interval; /* measurements between two checkpoints (0: no checkpoint) */
+	bool resume;                          /* continue from the last checkpoint */
+	unsigned long int n_extend;           /* measurements added to the campaign of the last checkpoint */
+	unsigned int convergence_ppd;         /* max |t| evaluations per decade of measurements (0: no convergence curve) */
+	double stop_threshold;                /* stop when max |t| exceeds it at two consecutive evaluations (0: never) */
+	bool with_cpa;                        /* correlation power analysis with the leakage model of the implementation */
+	bool with_histogram;                  /* chi-square test on the histograms of the samples */
+	bool with_information;                /* SNR and mutual information with the intermediate of the implementation */
+	std::vector<unsigned int> template_poi; /* points of interest of the templates (empty: no templates) */
+	bool with_hotspots;                   /* write the per-instruction leakage hotspot report */
+	bool with_control;                    /* also run the fixed-vs-fixed and random-vs-random control tests */
+	unsigned int anova_classes;           /* ANOVA F-test on the classes of the intermediate (ANOVA_NONE: disabled) */
+	unsigned int n_thread;                /* threads of the t-tests and histograms, each owning a slice of the samples */
+	unsigned int sparse_buckets;          /* buckets of the envelope of the sparse t-test results (0: disabled) */
+	unsigned int n_worker;                /* measurement workers, each with its own cpu, input generator and accumulators */
+	unsigned int n_producer;              /* simulation threads of the pipeline (0: not pipelined) */
+	unsigned int n_consumer;              /* statistics threads of the pipeline, each with its own accumulators */
 } Options;
 
 const Options default_options =
@@ -54,7 +92,36 @@ const Options default_options =
 	false,
 	0,
 	false,
-	false /* TODO: set it to true after functionality has been verified */
+	false, /* TODO: set it to true after functionality has been verified */
+	0.0,
+	{},
+	1,
+	4.0,
+	false,
+	64,
+	false,
+	1,
+	0,
+	{},
+	"",
+	{},
+	0,
+	false,
+	0,
+	0,
+	0.0,
+	false,
+	false,
+	false,
+	{},
+	false,
+	false,
+	ANOVA_NONE,
+	1,
+	0,
+	1,
+	0,
+	0
 };
 
 #endif
@@ -0,0 +1,72 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Elimination of constant samples
+ *
+ ******************************************************************************/
+
+#ifndef __SAMPLE_FILTER_H__
+#define __SAMPLE_FILTER_H__
+
+#include <vector>
+#include "state_file.h"
+
+/* Learns from warm-up traces which samples never change, then compacts
+   traces to the remaining samples. remap gives the index in the full trace
+   of each sample of a compacted trace. A dropped sample that changes after
+   the warm-up is appended to the compacted traces again: all its previous
+   values are known (the constant), so the statistics stay exact */
+class Sample_filter
+{
+	private:
+		unsigned int n_sample;
+		unsigned long int n_learnt;
+		bool frozen;
+		std::vector<unsigned int> constant_value;
+		std::vector<bool> is_constant;
+		std::vector<unsigned int> remap;
+		std::vector<unsigned int> dropped;
+
+	public:
+		Sample_filter(unsigned int n_sample);
+		~Sample_filter();
+		void learn(const std::vector<unsigned int> &trace);
+		void freeze(void);
+		bool is_frozen(void) const;
+		unsigned int get_n_sample(void) const;
+		unsigned int get_n_kept(void) const;
+		unsigned int get_constant_value(unsigned int kept_idx) const;
+		const std::vector<unsigned int> &get_remap(void) const;
+		const std::vector<unsigned int> &get_constant_values(void) const;
+		unsigned int compact(const std::vector<unsigned int> &trace, std::vector<unsigned int> &out);
+		std::vector<double> expand(const std::vector<double> &vec) const;
+		void save(State_writer &writer) const;
+		void load(State_reader &reader);
+};
+
+#endif
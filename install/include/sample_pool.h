@@ -0,0 +1,72 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Thread pool partitioning the samples of the accumulators
+ *
+ ******************************************************************************/
+
+#ifndef __SAMPLE_POOL_H__
+#define __SAMPLE_POOL_H__
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/* Fixed pool of n_thread threads (the calling thread is thread 0). run()
+   splits the samples [0, n_sample) into n_thread slices and calls the task
+   on each slice, in parallel, then waits for all of them. The slice of a
+   thread only depends on n_sample, so each thread keeps updating the same
+   part of the accumulator arrays: traces are broadcast to all the threads
+   and the memory does not grow with the number of threads */
+class Sample_pool
+{
+	private:
+		unsigned int n_thread;
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::condition_variable start_cond;
+		std::condition_variable done_cond;
+		const std::function<void(unsigned int, unsigned int)> *task;
+		unsigned int n_sample;
+		unsigned long int generation;      /* number of calls to run() */
+		unsigned int n_running;
+		bool stopping;
+
+		void get_slice(unsigned int k, unsigned int n_sample, unsigned int &i0, unsigned int &i1) const;
+		void work(unsigned int k);
+
+	public:
+		Sample_pool(unsigned int n_thread);
+		~Sample_pool();
+		unsigned int get_n_thread(void) const;
+		void run(unsigned int n_sample, const std::function<void(unsigned int i0, unsigned int i1)> &task);
+};
+
+#endif
@@ -0,0 +1,72 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Measurement model (noise, bandwidth and sampling of an oscilloscope)
+ *
+ ******************************************************************************/
+
+#ifndef __SCOPE_H__
+#define __SCOPE_H__
+
+#include <cstdint>
+#include <vector>
+#include "options.h"
+
+/* The simulated trace goes through the following stages:
+   1. additive gaussian noise (noise_sigma, in Hamming weight units)
+   2. FIR low-pass filter (fir_taps), modelling the scope bandwidth
+   3. decimation by a factor 'decimation'
+   4. 8-bit ADC with adc_gain LSB per Hamming weight unit
+   The noise is generated from a counter-based RNG keyed by (seed, trace number),
+   so the same trace number always gets the same noise whatever the order in which
+   traces are processed. When all stages are disabled, traces are left untouched */
+class Scope
+{
+	private:
+		double noise_sigma;
+		std::vector<double> fir_taps;
+		unsigned int decimation;
+		double adc_gain;
+		uint64_t seed;
+		std::vector<double> analog;
+		std::vector<double> phases;           /* polyphase rows of the analog trace for the filter */
+		std::vector<double> filtered;         /* filter output at the decimated positions */
+
+		void add_noise(uint64_t trace_number);
+		void filter(void);
+
+	public:
+		Scope(Options &options);
+		~Scope();
+		bool is_enabled(void) const;
+		void set_seed(uint64_t seed);
+		uint64_t get_seed(void) const;
+		void apply(std::vector<unsigned int> &trace, uint64_t trace_number);
+};
+
+#endif
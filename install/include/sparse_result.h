@@ -0,0 +1,50 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Sparse t-test results
+ *
+ ******************************************************************************/
+
+#ifndef __SPARSE_RESULT_H__
+#define __SPARSE_RESULT_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Summary of the t-test t that stays small for long traces. The JSON file
+   holds max |t|, its sample and, for each sample with |t| > threshold, the
+   sample index, t, the pc and the source of the sample (null when the pc
+   trace does not match the samples). The envelope file is a
+   (n_bucket x 2) .npy matrix with the min and max of t on buckets of
+   consecutive samples, for plotting */
+void save_sparse_ttest(std::string json_filename, std::string envelope_filename, const std::vector<double> &t,
+	double threshold, unsigned int n_bucket, const std::vector<uint32_t> &pc_trace,
+	const std::vector<const char *> &source_trace);
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Batch of traces with duplicates merged
+ *
+ ******************************************************************************/
+
+#ifndef __TRACE_BATCH_H__
+#define __TRACE_BATCH_H__
+
+#include <cstdint>
+#include <vector>
+
+/* Traces of one class waiting for the batch update of the accumulators, as
+   the rows of a (n_row x n_sample) matrix of 8-bit samples. Identical traces
+   (e.g. without masking, or fixed inputs with few random bits) are stored
+   once with a weight: a trace is hashed and compared to the rows of the
+   batch with the same hash. The rows have the length of the first trace
+   added to the empty batch */
+class Trace_batch
+{
+	private:
+		unsigned int n_sample;
+		unsigned int n_trace;              /* traces added, i.e. sum of the weights */
+		std::vector<uint8_t> rows;
+		std::vector<unsigned int> weights;
+		std::vector<uint64_t> hashes;
+		std::vector<uint8_t> buffer;
+
+	public:
+		Trace_batch();
+		~Trace_batch();
+		void clear(void);
+		void add(const std::vector<unsigned int> &trace);
+		bool empty(void) const;
+		unsigned int get_n_trace(void) const;
+		unsigned int get_n_row(void) const;
+		const uint8_t *get_rows(void) const;
+		const unsigned int *get_weights(void) const;
+};
+
+uint64_t hash_samples(const uint8_t *x, unsigned int n);
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Lock-free ring of trace blocks between simulation and statistics threads
+ *
+ ******************************************************************************/
+
+#ifndef __TRACE_RING_H__
+#define __TRACE_RING_H__
+
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <memory>
+
+/* traces of consecutive measures, one row per trace in the order of
+   Campaign::simulate(): measure by measure, class by class */
+typedef struct
+{
+	unsigned long int batch_idx;
+	unsigned long int first_measure;
+	unsigned long int n_measure;
+	unsigned int n_sample;
+	unsigned int n_bit_sample;
+	std::vector<uint8_t> samples;         /* n_sample 8-bit samples per trace */
+	std::vector<uint32_t> bit_samples;    /* n_bit_sample transition masks per trace (-b) */
+	std::vector<uint32_t> inputs;         /* n_input words per trace */
+} Trace_block;
+
+/* Bounded multi-producer multi-consumer queue of block pointers. Each cell
+   has a sequence number telling whether it is free for the push of a given
+   position or holds the block for the pop of that position, so that pushes
+   and pops only contend on their own counter (one compare-and-swap each).
+   push() and pop() yield until they succeed: a full ring holds the producers
+   back until the consumers catch up */
+class Trace_ring
+{
+	private:
+		typedef struct
+		{
+			std::atomic<unsigned long int> sequence;
+			Trace_block *block;
+		} Cell;
+
+		std::unique_ptr<Cell[]> cells;
+		unsigned long int mask;            /* capacity - 1, the capacity being a power of 2 */
+		alignas(64) std::atomic<unsigned long int> head;  /* position of the next push */
+		alignas(64) std::atomic<unsigned long int> tail;  /* position of the next pop */
+
+	public:
+		Trace_ring(unsigned int capacity);
+		~Trace_ring();
+		bool try_push(Trace_block *block);
+		bool try_pop(Trace_block *&block);
+		void push(Trace_block *block);
+		Trace_block *pop(void);
+};
+
+#endif
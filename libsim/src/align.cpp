@@ -0,0 +1,167 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Alignment of traces with data dependent control flow
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "align.h"
+#include "utils.h"
+
+/* occurrence and event are packed in 24 + 8 bits next to the PC */
+#define KEY(pc, occurrence, event) ((static_cast<uint64_t>(pc) << 32) | ((occurrence) << 8) | (event))
+#define MAX_OCCURRENCE ((1 << 24) - 1)
+#define MAX_EVENT 255
+
+
+Aligner::Aligner()
+{
+	/* intentionally empty */
+}
+
+Aligner::~Aligner()
+{
+	/* intentionally empty */
+}
+
+static uint64_t hash_pc_trace(const std::vector<uint32_t> &pc_trace)
+{
+	/* FNV-1a on 32-bit words */
+	uint64_t h = FNV_OFFSET;
+	for (uint32_t pc : pc_trace)
+	{
+		h = fnv1a(h, pc);
+	}
+	return h;
+}
+
+/* consecutive events with the same PC belong to the same execution of the instruction */
+unsigned int Aligner::new_path(const std::vector<uint32_t> &pc_trace, uint64_t hash)
+{
+	std::unordered_map<uint32_t, unsigned int> occurrence;
+	Path path;
+	unsigned int event = 0;
+
+	path.pc_trace = pc_trace;
+	path.count[0] = 0;
+	path.count[1] = 0;
+	for (unsigned long int i = 0; i < pc_trace.size(); ++i)
+	{
+		uint32_t pc = pc_trace[i];
+		if (i == 0 || pc != pc_trace[i - 1])
+		{
+			event = 0;
+			occurrence[pc]++;
+		}
+		else
+		{
+			event++;
+		}
+		if (occurrence[pc] > MAX_OCCURRENCE || event > MAX_EVENT)
+		{
+			fprintf(stderr, "-- ERROR: too many occurrences of the instruction at 0x%08x for alignment\n", pc);
+			std::exit(EXIT_FAILURE);
+		}
+		uint64_t key = KEY(pc, occurrence[pc] - 1, event);
+		auto it = this->id_by_key.find(key);
+		if (it == this->id_by_key.end())
+		{
+			it = this->id_by_key.emplace(key, this->keys.size()/3).first;
+			this->keys.push_back(pc);
+			this->keys.push_back(occurrence[pc] - 1);
+			this->keys.push_back(event);
+		}
+		path.ids.push_back(it->second);
+	}
+	this->paths.push_back(path);
+	this->path_by_hash.emplace(hash, this->paths.size() - 1);
+	return this->paths.size() - 1;
+}
+
+/* returns the sample id of each sample of the trace */
+const std::vector<unsigned int> &Aligner::align(const std::vector<uint32_t> &pc_trace, unsigned int cls)
+{
+	uint64_t hash = hash_pc_trace(pc_trace);
+	unsigned int path_idx;
+	bool found = false;
+
+	auto range = this->path_by_hash.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (this->paths[it->second].pc_trace == pc_trace)
+		{
+			path_idx = it->second;
+			found = true;
+			break;
+		}
+	}
+	if (!found)
+	{
+		path_idx = this->new_path(pc_trace, hash);
+	}
+	this->paths[path_idx].count[cls]++;
+	return this->paths[path_idx].ids;
+}
+
+unsigned int Aligner::get_n_sample(void) const
+{
+	return this->keys.size()/3;
+}
+
+/* flattened (pc, occurrence, event) triplets, indexed by sample id */
+const std::vector<uint32_t> &Aligner::get_keys(void) const
+{
+	return this->keys;
+}
+
+/* number of traces of each class that took each path */
+void Aligner::report(std::string filename) const
+{
+	FILE *file = fopen(filename.c_str(), "w");
+
+	if (file == NULL)
+	{
+		fprintf(stderr, "-- ERROR: can not create %s\n", filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	printf("-- %lu execution path(s), %u aligned samples\n", this->paths.size(), this->get_n_sample());
+	fprintf(file, "# path n_event n_fixed n_random\n");
+	for (unsigned int i = 0; i < this->paths.size(); ++i)
+	{
+		const Path &path = this->paths[i];
+		printf("--   path %u: %lu events, %lu fixed, %lu random\n", i, path.pc_trace.size(), path.count[0], path.count[1]);
+		fprintf(file, "%u %lu %lu %lu\n", i, path.pc_trace.size(), path.count[0], path.count[1]);
+	}
+	fclose(file);
+}
@@ -0,0 +1,74 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Alignment of traces with data dependent control flow
+ *
+ ******************************************************************************/
+
+#ifndef __ALIGN_H__
+#define __ALIGN_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/* A sample is identified by the key (PC, occurrence, event): the address of
+   the instruction, how many times this instruction was executed before in
+   the trace, and the rank of the event within this execution. Every new key
+   gets the next sample id.
+   Traces are grouped by path (sequence of PCs of the events). The ids of a
+   path are computed once, so aligning a trace that follows a known path only
+   costs hashing and comparing its PC trace */
+class Aligner
+{
+	private:
+		typedef struct
+		{
+			std::vector<uint32_t> pc_trace;
+			std::vector<unsigned int> ids;
+			unsigned long int count[2];
+		} Path;
+
+		std::vector<Path> paths;
+		std::unordered_multimap<uint64_t, unsigned int> path_by_hash;
+		std::unordered_map<uint64_t, unsigned int> id_by_key;
+		std::vector<uint32_t> keys;           /* (pc, occurrence, event) of each id */
+
+		unsigned int new_path(const std::vector<uint32_t> &pc_trace, uint64_t hash);
+
+	public:
+		Aligner();
+		~Aligner();
+		const std::vector<unsigned int> &align(const std::vector<uint32_t> &pc_trace, unsigned int cls);
+		unsigned int get_n_sample(void) const;
+		const std::vector<uint32_t> &get_keys(void) const;
+		void report(std::string filename) const;
+};
+
+#endif
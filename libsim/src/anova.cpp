@@ -0,0 +1,183 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * One-way ANOVA F-test
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include "anova.h"
+
+
+Anova::Anova(unsigned int n_sample, unsigned int n_class)
+{
+	this->n_sample = n_sample;
+	this->n_class = n_class;
+	this->reset();
+}
+
+Anova::~Anova()
+{
+}
+
+void Anova::reset(void)
+{
+	this->n = 0;
+	this->n_c.assign(this->n_class, 0);
+	this->s.assign(static_cast<unsigned long int>(this->n_class)*this->n_sample, 0);
+	this->s2.assign(this->n_sample, 0);
+}
+
+void Anova::update(const std::vector<unsigned int> &vec, unsigned int cls)
+{
+	if (cls >= this->n_class)
+	{
+		fprintf(stderr, "-- ERROR: ANOVA class %u out of [0, %u)\n", cls, this->n_class);
+		std::exit(EXIT_FAILURE);
+	}
+
+	uint64_t *sc = this->s.data() + static_cast<unsigned long int>(cls)*this->n_sample;
+
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		sc[i] += vec[i];
+		this->s2[i] += static_cast<uint64_t>(vec[i])*vec[i];
+	}
+	this->n_c[cls]++;
+	this->n++;
+}
+
+unsigned int Anova::get_n_class_seen(void) const
+{
+	unsigned int k = 0;
+
+	for (auto count : this->n_c)
+	{
+		k += (count > 0);
+	}
+	return k;
+}
+
+unsigned long int Anova::get_n(void) const
+{
+	return this->n;
+}
+
+/* F = (SSB/(k - 1))/(SSW/(n - k)) over the k classes seen, 0 when undefined.
+   Infinite when the samples are a non-constant function of the class */
+std::vector<double> Anova::f_test(void) const
+{
+	std::vector<double> f(this->n_sample, 0.0);
+	unsigned int k = this->get_n_class_seen();
+
+	if (k < 2 || this->n <= k)
+	{
+		return f;
+	}
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		long double between = 0.0L;
+		long double total = 0.0L;
+		for (unsigned int c = 0; c < this->n_class; ++c)
+		{
+			if (this->n_c[c] > 0)
+			{
+				long double sc = this->s[static_cast<unsigned long int>(c)*this->n_sample + i];
+				between += sc*sc/this->n_c[c];
+				total += sc;
+			}
+		}
+		long double ssb = between - total*total/this->n;
+		long double ssw = this->s2[i] - between;
+		if (ssw > 0.0L)
+		{
+			f[i] = (ssb/(k - 1))/(ssw/(this->n - k));
+		}
+		else if (ssb > 0.0L)
+		{
+			f[i] = INFINITY;
+		}
+	}
+	return f;
+}
+
+void Anova::merge(const Anova &other)
+{
+	if (other.n_sample != this->n_sample || other.n_class != this->n_class)
+	{
+		fprintf(stderr, "-- ERROR: can not merge ANOVA of %u samples x %u classes and %u samples x %u classes\n",
+			this->n_sample, this->n_class, other.n_sample, other.n_class);
+		std::exit(EXIT_FAILURE);
+	}
+	for (unsigned long int k = 0; k < this->s.size(); ++k)
+	{
+		this->s[k] += other.s[k];
+	}
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		this->s2[i] += other.s2[i];
+	}
+	for (unsigned int c = 0; c < this->n_class; ++c)
+	{
+		this->n_c[c] += other.n_c[c];
+	}
+	this->n += other.n;
+}
+
+void Anova::save(State_writer &writer)
+{
+	writer.write_tag("Anova");
+	writer.write_u64(this->n_sample);
+	writer.write_u64(this->n_class);
+	writer.write_u64(this->n);
+	writer.write(this->n_c);
+	writer.write(this->s);
+	writer.write(this->s2);
+}
+
+void Anova::load(State_reader &reader)
+{
+	reader.read_tag("Anova");
+	this->n_sample = reader.read_u64();
+	this->n_class = reader.read_u64();
+	this->reset();
+	this->n = reader.read_u64();
+	reader.read(this->n_c);
+	reader.read(this->s);
+	reader.read(this->s2);
+	if (this->n_c.size() != this->n_class || this->s.size() != static_cast<unsigned long int>(this->n_class)*this->n_sample ||
+		this->s2.size() != this->n_sample)
+	{
+		fprintf(stderr, "-- ERROR: %s: inconsistent ANOVA\n", reader.get_filename().c_str());
+		std::exit(EXIT_FAILURE);
+	}
+}
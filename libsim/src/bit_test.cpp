@@ -0,0 +1,222 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Bit-level t-test and chi-square test
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include "bit_test.h"
+
+#define N_PLANE 8
+#define MAX_PENDING ((1 << N_PLANE) - 1)
+
+
+Bit_test::Bit_test(unsigned int n_sample)
+{
+	this->n_sample = n_sample;
+	this->reset();
+}
+
+Bit_test::~Bit_test()
+{
+}
+
+void Bit_test::reset(void)
+{
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->n[cls] = 0;
+		this->n_pending[cls] = 0;
+		this->planes[cls].assign(N_PLANE*this->n_sample, 0);
+		this->ones[cls].assign(32*this->n_sample, 0);
+	}
+}
+
+/* adds the bit-sliced counters to the 64-bit counters */
+static void add_planes(const uint32_t *p, uint64_t *o, unsigned int n_sample)
+{
+	for (unsigned int i = 0; i < n_sample; ++i, p += N_PLANE, o += 32)
+	{
+		for (unsigned int j = 0; j < N_PLANE; ++j)
+		{
+			uint32_t w = p[j];
+			while (w)
+			{
+				o[__builtin_ctz(w)] += 1UL << j;
+				w &= w - 1;
+			}
+		}
+	}
+}
+
+void Bit_test::flush(unsigned int cls)
+{
+	add_planes(this->planes[cls].data(), this->ones[cls].data(), this->n_sample);
+	this->planes[cls].assign(N_PLANE*this->n_sample, 0);
+	this->n_pending[cls] = 0;
+}
+
+void Bit_test::update(unsigned int cls, const std::vector<uint32_t> &vec)
+{
+	uint32_t *p = this->planes[cls].data();
+
+	for (unsigned int i = 0; i < this->n_sample; ++i, p += N_PLANE)
+	{
+		uint32_t carry = vec[i];
+		for (unsigned int j = 0; carry != 0; ++j)
+		{
+			uint32_t t = p[j] & carry;
+			p[j] ^= carry;
+			carry = t;
+		}
+	}
+	this->n[cls]++;
+	if (++this->n_pending[cls] == MAX_PENDING)
+	{
+		this->flush(cls);
+	}
+}
+
+void Bit_test::update1(const std::vector<uint32_t> &vec)
+{
+	this->update(0, vec);
+}
+
+void Bit_test::update2(const std::vector<uint32_t> &vec)
+{
+	this->update(1, vec);
+}
+
+void Bit_test::merge(const Bit_test &other)
+{
+	if (other.n_sample != this->n_sample)
+	{
+		fprintf(stderr, "-- ERROR: can not merge bit tests of %u and %u samples\n", this->n_sample, other.n_sample);
+		std::exit(EXIT_FAILURE);
+	}
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		for (unsigned int i = 0; i < 32*this->n_sample; ++i)
+		{
+			this->ones[cls][i] += other.ones[cls][i];
+		}
+		add_planes(other.planes[cls].data(), this->ones[cls].data(), this->n_sample);
+		this->n[cls] += other.n[cls];
+	}
+}
+
+void Bit_test::save(State_writer &writer)
+{
+	writer.write_tag("Bit_test");
+	writer.write_u64(this->n_sample);
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->flush(cls);
+		writer.write_u64(this->n[cls]);
+		writer.write(this->ones[cls]);
+	}
+}
+
+void Bit_test::load(State_reader &reader)
+{
+	reader.read_tag("Bit_test");
+	this->n_sample = reader.read_u64();
+	this->reset();
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->n[cls] = reader.read_u64();
+		reader.read(this->ones[cls]);
+		if (this->ones[cls].size() != 32UL*this->n_sample)
+		{
+			fprintf(stderr, "-- ERROR: %s: inconsistent bit counts\n", reader.get_filename().c_str());
+			std::exit(EXIT_FAILURE);
+		}
+	}
+}
+
+/* Welch t-test on the bits, with p = k/n and the unbiased variance p(1 - p)n/(n - 1) */
+std::vector<double> Bit_test::t_test(void)
+{
+	std::vector<double> t;
+	double n1 = this->n[0];
+	double n2 = this->n[1];
+
+	this->flush(0);
+	this->flush(1);
+	for (unsigned int i = 0; i < 32*this->n_sample; ++i)
+	{
+		double p1 = this->ones[0][i]/n1;
+		double p2 = this->ones[1][i]/n2;
+		double var1 = p1*(1.0 - p1)*n1/(n1 - 1);
+		double var2 = p2*(1.0 - p2)*n2/(n2 - 1);
+		double term = sqrt(var1/n1 + var2/n2);
+		if (term == 0.0)
+		{
+			t.push_back(0.0);
+		}
+		else
+		{
+			t.push_back((p1 - p2)/term);
+		}
+	}
+	return t;
+}
+
+/* Pearson chi-square statistic (1 degree of freedom) of the 2x2 contingency
+   table (class, bit value) */
+std::vector<double> Bit_test::chi2_test(void)
+{
+	std::vector<double> chi2;
+	double n1 = this->n[0];
+	double n2 = this->n[1];
+
+	this->flush(0);
+	this->flush(1);
+	for (unsigned int i = 0; i < 32*this->n_sample; ++i)
+	{
+		double a = this->ones[0][i];
+		double b = n1 - a;
+		double c = this->ones[1][i];
+		double d = n2 - c;
+		double den = (a + b)*(c + d)*(a + c)*(b + d);
+		if (den == 0.0)
+		{
+			chi2.push_back(0.0);
+		}
+		else
+		{
+			chi2.push_back((n1 + n2)*(a*d - b*c)*(a*d - b*c)/den);
+		}
+	}
+	return chi2;
+}
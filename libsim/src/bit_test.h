@@ -0,0 +1,71 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Bit-level t-test and chi-square test
+ *
+ ******************************************************************************/
+
+#ifndef __BIT_TEST_H__
+#define __BIT_TEST_H__
+
+#include <cstdint>
+#include <vector>
+#include "state_file.h"
+
+/* Each sample is a 32-bit transition mask, i.e. 32 binary samples. For binary
+   samples the number of ones per class is a sufficient statistic, so only
+   counts are accumulated. The counts are kept in bit-sliced (vertical)
+   counters: plane j holds bit j of the 32 counters of a sample, and adding a
+   mask is a ripple-carry over the planes. The planes are flushed to 64-bit
+   counters before they overflow. Results are indexed by 32*sample + bit */
+class Bit_test
+{
+	private:
+		unsigned int n_sample;
+		unsigned long int n[2];
+		unsigned int n_pending[2];
+		std::vector<uint32_t> planes[2];
+		std::vector<uint64_t> ones[2];
+
+		void update(unsigned int cls, const std::vector<uint32_t> &vec);
+		void flush(unsigned int cls);
+
+	public:
+		Bit_test(unsigned int n_sample);
+		~Bit_test();
+		void reset(void);
+		void update1(const std::vector<uint32_t> &vec);
+		void update2(const std::vector<uint32_t> &vec);
+		void merge(const Bit_test &other);
+		void save(State_writer &writer);
+		void load(State_reader &reader);
+		std::vector<double> t_test(void);
+		std::vector<double> chi2_test(void);
+};
+
+#endif
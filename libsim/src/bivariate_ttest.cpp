@@ -0,0 +1,296 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Bivariate second-order t-test
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "bivariate_ttest.h"
+
+/* traces buffered before they are accumulated */
+#define BATCH_SIZE 32
+/* pair sums of a block: 4 sums of 8 bytes for block_rows*window pairs */
+#define BLOCK_BYTES (128*1024)
+
+
+Bivariate_ttest::Bivariate_ttest(unsigned int n_sample, unsigned int window)
+{
+	this->n_sample = n_sample;
+	this->window = (window < 1) ? 1 : window;
+	this->block_rows = BLOCK_BYTES/(4*sizeof(uint64_t)*this->window);
+	if (this->block_rows < 1)
+	{
+		this->block_rows = 1;
+	}
+	this->reset();
+}
+
+Bivariate_ttest::~Bivariate_ttest()
+{
+}
+
+void Bivariate_ttest::reset(void)
+{
+	unsigned long int n_pair = static_cast<unsigned long int>(this->n_sample)*this->window;
+	unsigned long int stride = 2*(this->n_sample + this->window);
+
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->n[cls] = 0;
+		this->n_pending[cls] = 0;
+		this->s1[cls].assign(this->n_sample, 0);
+		this->s2[cls].assign(this->n_sample, 0);
+		this->s11[cls].assign(n_pair, 0);
+		this->s21[cls].assign(n_pair, 0);
+		this->s12[cls].assign(n_pair, 0);
+		this->s22[cls].assign(n_pair, 0);
+		this->batch[cls].assign(BATCH_SIZE*stride, 0);
+	}
+}
+
+unsigned int Bivariate_ttest::get_n_sample(void) const
+{
+	return this->n_sample;
+}
+
+unsigned int Bivariate_ttest::get_window(void) const
+{
+	return this->window;
+}
+
+void Bivariate_ttest::update(unsigned int cls, const std::vector<unsigned int> &vec)
+{
+	unsigned long int stride = 2*(this->n_sample + this->window);
+	uint32_t *x = this->batch[cls].data() + this->n_pending[cls]*stride;
+	uint32_t *x2 = x + this->n_sample + this->window;
+
+	/* samples past the end stay at 0, so pairs beyond the trace add nothing */
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		x[i] = vec[i];
+		x2[i] = x[i]*x[i];
+		this->s1[cls][i] += x[i];
+		this->s2[cls][i] += x2[i];
+	}
+	this->n[cls]++;
+	if (++this->n_pending[cls] == BATCH_SIZE)
+	{
+		this->flush(cls);
+	}
+}
+
+/* x_i^2 x_j^2 <= 255^4 fits in 32 bits, so products are computed on 32-bit
+   lanes and only widened for the accumulation */
+void Bivariate_ttest::accumulate(unsigned int cls, const uint32_t *batch, unsigned int n_trace)
+{
+	unsigned long int stride = 2*(this->n_sample + this->window);
+	unsigned int w = this->window;
+
+	for (unsigned int i0 = 0; i0 < this->n_sample; i0 += this->block_rows)
+	{
+		unsigned int i1 = (i0 + this->block_rows < this->n_sample) ? i0 + this->block_rows : this->n_sample;
+		for (unsigned int b = 0; b < n_trace; ++b)
+		{
+			const uint32_t *x = batch + b*stride;
+			const uint32_t *x2 = x + this->n_sample + this->window;
+			for (unsigned int i = i0; i < i1; ++i)
+			{
+				const uint32_t xi = x[i];
+				const uint32_t xi2 = x2[i];
+				const uint32_t *xj = x + i + 1;
+				const uint32_t *xj2 = x2 + i + 1;
+				uint64_t * __restrict__ s11 = this->s11[cls].data() + static_cast<unsigned long int>(i)*w;
+				uint64_t * __restrict__ s21 = this->s21[cls].data() + static_cast<unsigned long int>(i)*w;
+				uint64_t * __restrict__ s12 = this->s12[cls].data() + static_cast<unsigned long int>(i)*w;
+				uint64_t * __restrict__ s22 = this->s22[cls].data() + static_cast<unsigned long int>(i)*w;
+				for (unsigned int k = 0; k < w; ++k)
+				{
+					s11[k] += xi*xj[k];
+					s21[k] += xi2*xj[k];
+					s12[k] += xi*xj2[k];
+					s22[k] += xi2*xj2[k];
+				}
+			}
+		}
+	}
+}
+
+void Bivariate_ttest::flush(unsigned int cls)
+{
+	this->accumulate(cls, this->batch[cls].data(), this->n_pending[cls]);
+	this->n_pending[cls] = 0;
+}
+
+/* the pending traces of the other test are accumulated here */
+void Bivariate_ttest::merge(const Bivariate_ttest &other)
+{
+	if (other.n_sample != this->n_sample || other.window != this->window)
+	{
+		fprintf(stderr, "-- ERROR: can not merge bivariate t-tests of %u samples (window %u) and %u samples (window %u)\n",
+			this->n_sample, this->window, other.n_sample, other.window);
+		std::exit(EXIT_FAILURE);
+	}
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->flush(cls);
+		for (unsigned int i = 0; i < this->n_sample; ++i)
+		{
+			this->s1[cls][i] += other.s1[cls][i];
+			this->s2[cls][i] += other.s2[cls][i];
+		}
+		for (unsigned long int p = 0; p < this->s11[cls].size(); ++p)
+		{
+			this->s11[cls][p] += other.s11[cls][p];
+			this->s21[cls][p] += other.s21[cls][p];
+			this->s12[cls][p] += other.s12[cls][p];
+			this->s22[cls][p] += other.s22[cls][p];
+		}
+		this->accumulate(cls, other.batch[cls].data(), other.n_pending[cls]);
+		this->n[cls] += other.n[cls];
+	}
+}
+
+void Bivariate_ttest::save(State_writer &writer)
+{
+	writer.write_tag("Bivariate_ttest");
+	writer.write_u64(this->n_sample);
+	writer.write_u64(this->window);
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->flush(cls);
+		writer.write_u64(this->n[cls]);
+		writer.write(this->s1[cls]);
+		writer.write(this->s2[cls]);
+		writer.write(this->s11[cls]);
+		writer.write(this->s21[cls]);
+		writer.write(this->s12[cls]);
+		writer.write(this->s22[cls]);
+	}
+}
+
+void Bivariate_ttest::load(State_reader &reader)
+{
+	reader.read_tag("Bivariate_ttest");
+	this->n_sample = reader.read_u64();
+	this->window = reader.read_u64();
+	*this = Bivariate_ttest(this->n_sample, this->window);
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		unsigned long int n_pair = static_cast<unsigned long int>(this->n_sample)*this->window;
+		this->n[cls] = reader.read_u64();
+		reader.read(this->s1[cls]);
+		reader.read(this->s2[cls]);
+		reader.read(this->s11[cls]);
+		reader.read(this->s21[cls]);
+		reader.read(this->s12[cls]);
+		reader.read(this->s22[cls]);
+		if (this->s1[cls].size() != this->n_sample || this->s2[cls].size() != this->n_sample
+			|| this->s11[cls].size() != n_pair || this->s21[cls].size() != n_pair
+			|| this->s12[cls].size() != n_pair || this->s22[cls].size() != n_pair)
+		{
+			fprintf(stderr, "-- ERROR: %s: inconsistent pair sums\n", reader.get_filename().c_str());
+			std::exit(EXIT_FAILURE);
+		}
+	}
+}
+
+/* exact test of a zero variance: n*S2 == S1^2 */
+bool Bivariate_ttest::is_constant(unsigned int cls, unsigned int i) const
+{
+	unsigned __int128 s1 = this->s1[cls][i];
+
+	return static_cast<unsigned __int128>(this->n[cls])*this->s2[cls][i] == s1*s1;
+}
+
+void Bivariate_ttest::update1(const std::vector<unsigned int> &vec)
+{
+	this->update(0, vec);
+}
+
+void Bivariate_ttest::update2(const std::vector<unsigned int> &vec)
+{
+	this->update(1, vec);
+}
+
+/* With a = mean_i, b = mean_j, the centered product y has
+     sum y   = S11 - n a b
+     sum y^2 = S22 - 2b S21 - 2a S12 + b^2 S20 + a^2 S02 + 4ab S11 - 3n a^2 b^2
+   and the t-test is run on mean(y) and var(y) = sum y^2/n - mean(y)^2.
+   The result is a n_sample x window map, pairs past the trace are set to 0 */
+std::vector<double> Bivariate_ttest::t_test(void)
+{
+	std::vector<double> t(static_cast<unsigned long int>(this->n_sample)*this->window, 0.0);
+	long double m[2];
+	long double v[2];
+
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->flush(cls);
+	}
+	if (this->n[0] == 0 || this->n[1] == 0)
+	{
+		return t;
+	}
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		for (unsigned int d = 1; d <= this->window && i + d < this->n_sample; ++d)
+		{
+			unsigned int j = i + d;
+			unsigned long int p = static_cast<unsigned long int>(i)*this->window + d - 1;
+			for (unsigned int cls = 0; cls < 2; ++cls)
+			{
+				if (this->is_constant(cls, i) || this->is_constant(cls, j))
+				{
+					/* y is 0 in every trace, avoid rounding noise */
+					m[cls] = 0.0;
+					v[cls] = 0.0;
+					continue;
+				}
+				long double n = this->n[cls];
+				long double a = this->s1[cls][i]/n;
+				long double b = this->s1[cls][j]/n;
+				long double sy = this->s11[cls][p] - n*a*b;
+				long double sy2 = this->s22[cls][p] - 2*b*this->s21[cls][p] - 2*a*this->s12[cls][p]
+					+ b*b*this->s2[cls][i] + a*a*this->s2[cls][j] + 4*a*b*this->s11[cls][p] - 3*n*a*a*b*b;
+				m[cls] = sy/n;
+				v[cls] = sy2/n - m[cls]*m[cls];
+			}
+			long double term = sqrtl(v[0]/this->n[0] + v[1]/this->n[1]);
+			if (term > 0.0)
+			{
+				t[p] = (m[0] - m[1])/term;
+			}
+		}
+	}
+	return t;
+}
@@ -0,0 +1,81 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Bivariate second-order t-test
+ *
+ ******************************************************************************/
+
+#ifndef __BIVARIATE_TTEST_H__
+#define __BIVARIATE_TTEST_H__
+
+#include <cstdint>
+#include <vector>
+#include "state_file.h"
+
+/* Welch t-test on the centered product (x_i - mean_i)(x_j - mean_j) of every
+   sample pair (i, i + d), 1 <= d <= window. The per-pair sums of x_i x_j,
+   x_i^2 x_j, x_i x_j^2 and x_i^2 x_j^2 are kept in 64-bit integers (samples
+   are 8-bit) and the central moments are only computed by t_test().
+   Traces are buffered and accumulated by batches, one block of rows at a time,
+   so that the accumulators of a block stay in cache for the whole batch */
+class Bivariate_ttest
+{
+	private:
+		unsigned int n_sample;
+		unsigned int window;
+		unsigned int block_rows;
+		unsigned long int n[2];
+		std::vector<uint64_t> s1[2];       /* sum of x_i */
+		std::vector<uint64_t> s2[2];       /* sum of x_i^2 */
+		std::vector<uint64_t> s11[2];      /* sum of x_i x_(i+d) at i*window + d - 1 */
+		std::vector<uint64_t> s21[2];      /* sum of x_i^2 x_(i+d) */
+		std::vector<uint64_t> s12[2];      /* sum of x_i x_(i+d)^2 */
+		std::vector<uint64_t> s22[2];      /* sum of x_i^2 x_(i+d)^2 */
+		unsigned int n_pending[2];
+		std::vector<uint32_t> batch[2];    /* pending traces (x then x^2), zero padded by window */
+
+		void update(unsigned int cls, const std::vector<unsigned int> &vec);
+		void accumulate(unsigned int cls, const uint32_t *batch, unsigned int n_trace);
+		void flush(unsigned int cls);
+		bool is_constant(unsigned int cls, unsigned int i) const;
+
+	public:
+		Bivariate_ttest(unsigned int n_sample, unsigned int window);
+		~Bivariate_ttest();
+		void reset(void);
+		unsigned int get_n_sample(void) const;
+		unsigned int get_window(void) const;
+		void update1(const std::vector<unsigned int> &vec);
+		void update2(const std::vector<unsigned int> &vec);
+		void merge(const Bivariate_ttest &other);
+		void save(State_writer &writer);
+		void load(State_reader &reader);
+		std::vector<double> t_test(void);
+};
+
+#endif
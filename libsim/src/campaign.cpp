@@ -0,0 +1,1622 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * t-test campaign (fixed vs random)
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include <random>
+#include <iostream>
+#include <thread>
+#include "progress_bar.h"
+#include "campaign.h"
+#include "opcodes.h"
+
+#define MIN_CONVERGENCE_POINT 100
+/* threshold of the hotspot report and of the sparse t-tests without -e */
+#define HOTSPOT_THRESHOLD 4.5
+/* traces buffered before the batch update of the t-tests and histograms,
+   identical traces being merged */
+#define BATCH_TRACES 64
+/* measures pulled at once by a worker (-J) */
+#define WORKER_BATCH 256
+
+
+Campaign::Campaign(Options &options, const Sec_algo &sec_algo) :
+	options(options), sec_algo(sec_algo), cpu(options), scope(options)
+{
+	std::random_device random_dev;
+
+	this->rnd_gen_uint32.seed(random_dev());
+	this->scope.set_seed((static_cast<uint64_t>(random_dev()) << 32) | random_dev());
+	this->batch_seed = (static_cast<uint64_t>(random_dev()) << 32) | random_dev();
+	this->next_moment_batch = 0;
+	this->inputs.resize(sec_algo.n_input, 0);
+	this->initialized = false;
+	this->n_over_threshold = 0;
+	this->sample_filter_ptr = nullptr;
+	this->ttest_ptr = nullptr;
+	this->n_trace_per_measure = options.with_control ? 3 : 2;
+	this->fvf_ttest_ptr = nullptr;
+	this->rvr_ttest_ptr = nullptr;
+	this->moment_ttest_ptr = nullptr;
+	this->bivariate_ttest_ptr = nullptr;
+	this->cpa_ptr = nullptr;
+	this->bit_test_ptr = nullptr;
+	this->histogram_test_ptr = nullptr;
+	this->conditional_histogram_ptr = nullptr;
+	this->template_builder_ptr = nullptr;
+	this->hotspot_ptr = nullptr;
+	this->anova_ptr = nullptr;
+	this->sample_pool_ptr = nullptr;
+	this->aligner_ptr = nullptr;
+	this->aligned_ttest_ptr = nullptr;
+	this->trace_npy_ptr = nullptr;
+	this->label_npy_ptr = nullptr;
+	this->input_npy_ptr = nullptr;
+	this->bit_trace_npy_ptr = nullptr;
+	this->trace_cpu_ptr = &this->cpu;
+}
+
+Campaign::~Campaign()
+{
+	delete this->sample_filter_ptr;
+	delete this->ttest_ptr;
+	delete this->fvf_ttest_ptr;
+	delete this->rvr_ttest_ptr;
+	delete this->moment_ttest_ptr;
+	delete this->bivariate_ttest_ptr;
+	delete this->cpa_ptr;
+	delete this->bit_test_ptr;
+	delete this->histogram_test_ptr;
+	delete this->conditional_histogram_ptr;
+	delete this->template_builder_ptr;
+	delete this->hotspot_ptr;
+	delete this->anova_ptr;
+	delete this->sample_pool_ptr;
+	delete this->aligner_ptr;
+	delete this->aligned_ttest_ptr;
+	delete this->trace_npy_ptr;
+	delete this->label_npy_ptr;
+	delete this->input_npy_ptr;
+	delete this->bit_trace_npy_ptr;
+	for (auto &pending : this->pending_moments)
+	{
+		delete pending.second;
+	}
+}
+
+/* name of an additional result file: t_test.npy -> t_test_<suffix><extension> */
+std::string Campaign::output_filename(std::string suffix, std::string extension) const
+{
+	std::string base = this->options.t_test_filename;
+	std::string::size_type pos = base.rfind(".npy");
+
+	if (pos != std::string::npos && pos == base.length() - 4)
+	{
+		base.erase(pos);
+	}
+	return base + "_" + suffix + extension;
+}
+
+/* traces are stored as one (2*n_measure, n_sample) matrix, fixed and random
+   measures being interleaved (3*n_measure rows with the second fixed input of
+   the control tests). The class of each row (0: fixed, 1: random, 2: second
+   fixed) is stored in the labels file, the inputs of each row in the inputs file */
+void Campaign::open_trace_files(unsigned long int n_sample)
+{
+	unsigned long int n_row = this->n_trace_per_measure*this->options.n_measure;
+	std::string suffix = "_n_measure_" + std::to_string(this->options.n_measure) + ".npy";
+
+	/* samples are Hamming weights/distances of 32-bit words or 8-bit ADC codes */
+	this->trace_npy_ptr = new Npy_matrix("traces" + suffix, "|u1", n_row, n_sample);
+	this->label_npy_ptr = new Npy_matrix("labels" + suffix, "|u1", n_row);
+	this->input_npy_ptr = new Npy_matrix("inputs" + suffix, "<u4", n_row, this->sec_algo.n_input);
+	if (this->options.with_bit_leakage)
+	{
+		/* one 32-bit transition mask per event, unpack with np.unpackbits(x.view(np.uint8), bitorder='little') */
+		this->bit_trace_npy_ptr = new Npy_matrix("bit_traces" + suffix, "<u4", n_row, this->bit_trace.size());
+	}
+}
+
+void Campaign::save_trace(unsigned long int row_idx, Input_class input_class)
+{
+	std::vector<unsigned int> label(1, input_class);
+
+	this->trace_npy_ptr->write_row(row_idx, this->trace);
+	this->label_npy_ptr->write_row(row_idx, label);
+	this->input_npy_ptr->write_row(row_idx, this->inputs);
+	if (this->options.with_bit_leakage)
+	{
+		this->bit_trace_npy_ptr->write_row(row_idx, this->bit_trace);
+	}
+}
+
+/* simulate one measure and pass its trace through the measurement model */
+void Campaign::acquire(unsigned long int measure_idx, Input_class input_class)
+{
+	this->sec_algo.measure(this->rnd_gen_uint32, &this->cpu, input_class, this->inputs.data());
+	this->trace = this->cpu.get_pwr_trace();
+	this->scope.apply(this->trace, this->n_trace_per_measure*measure_idx + input_class);
+	if (this->options.with_bit_leakage)
+	{
+		this->bit_trace = this->cpu.get_pwr_bit_trace();
+	}
+	if (this->options.with_alignment)
+	{
+		this->pc_trace = this->cpu.get_pwr_pc_trace();
+	}
+}
+
+/* one trace through the accumulators */
+void Campaign::accumulate(unsigned long int measure_idx, Input_class input_class)
+{
+	if (!this->initialized)
+	{
+		this->init();
+	}
+	if (input_class != INPUT_FIXED_2)
+	{
+		this->update(input_class);
+	}
+	if (this->fvf_ttest_ptr != nullptr)
+	{
+		this->update_control(measure_idx, input_class);
+	}
+	if (this->options.save_traces)
+	{
+		this->save_trace(this->n_trace_per_measure*measure_idx + input_class, input_class);
+	}
+}
+
+/* the traces of one measure, one per input class */
+void Campaign::simulate(unsigned long int measure_idx)
+{
+	for (unsigned int cls = 0; cls < this->n_trace_per_measure; ++cls)
+	{
+		this->acquire(measure_idx, static_cast<Input_class>(cls));
+		this->accumulate(measure_idx, static_cast<Input_class>(cls));
+	}
+}
+
+/* called once the length of the traces is known */
+void Campaign::init(void)
+{
+	this->initialized = true;
+	/* not started by the producers of -L, which have no accumulators */
+	this->sample_pool_ptr = (this->options.n_thread > 1) ? new Sample_pool(this->options.n_thread) : nullptr;
+	if (this->options.with_alignment)
+	{
+		this->aligner_ptr = new Aligner();
+		this->aligned_ttest_ptr = new Aligned_ttest();
+	}
+	else
+	{
+		this->sample_filter_ptr = new Sample_filter(this->trace.size());
+		if (this->options.n_warmup == 0)
+		{
+			this->end_warmup();
+		}
+	}
+	if (this->options.with_bit_leakage)
+	{
+		this->bit_test_ptr = new Bit_test(this->bit_trace.size());
+	}
+	if (this->options.with_control)
+	{
+		this->fvf_ttest_ptr = new Power_sum_ttest(this->trace.size());
+		this->rvr_ttest_ptr = new Power_sum_ttest(this->trace.size());
+	}
+	if (this->options.with_histogram)
+	{
+		/* Hamming weights/distances of 32-bit words, or 8-bit ADC codes */
+		this->histogram_test_ptr = new Histogram_test(this->trace.size(), this->scope.is_enabled() ? 256 : 33);
+	}
+	if (this->options.with_information)
+	{
+		if (this->sec_algo.intermediate == nullptr)
+		{
+			fprintf(stderr, "-- ERROR: %s provides no intermediate for the SNR and mutual information\n", this->sec_algo.name.c_str());
+			std::exit(EXIT_FAILURE);
+		}
+		this->conditional_histogram_ptr = new Conditional_histogram(this->trace.size(), this->sec_algo.n_value,
+			this->scope.is_enabled() ? 256 : 33);
+	}
+	if (this->options.template_poi.size() > 0)
+	{
+		if (this->sec_algo.intermediate == nullptr)
+		{
+			fprintf(stderr, "-- ERROR: %s provides no intermediate for the template classes\n", this->sec_algo.name.c_str());
+			std::exit(EXIT_FAILURE);
+		}
+		for (auto idx : this->options.template_poi)
+		{
+			if (idx >= this->trace.size())
+			{
+				fprintf(stderr, "-- ERROR: point of interest %u is beyond the %lu samples of the traces\n", idx, this->trace.size());
+				std::exit(EXIT_FAILURE);
+			}
+		}
+		this->template_trace.resize(this->options.template_poi.size());
+		this->template_builder_ptr = new Template_builder(this->options.template_poi.size(), this->sec_algo.n_value);
+	}
+	if (this->options.anova_classes != ANOVA_NONE)
+	{
+		if (this->sec_algo.intermediate == nullptr)
+		{
+			fprintf(stderr, "-- ERROR: %s provides no intermediate for the ANOVA classes\n", this->sec_algo.name.c_str());
+			std::exit(EXIT_FAILURE);
+		}
+		/* Hamming weights of values below n_value */
+		unsigned int n_class = (this->options.anova_classes == ANOVA_HW) ? 33 - __builtin_clz((this->sec_algo.n_value - 1) | 1)
+			: this->sec_algo.n_value;
+		this->anova_ptr = new Anova(this->trace.size(), n_class);
+	}
+	if (this->options.bivariate_window > 0)
+	{
+		this->bivariate_ttest_ptr = new Bivariate_ttest(this->trace.size(), this->options.bivariate_window);
+	}
+	else if (this->options.poi.size() > 0)
+	{
+		for (auto idx : this->options.poi)
+		{
+			if (idx >= this->trace.size())
+			{
+				fprintf(stderr, "-- ERROR: point of interest %u is beyond the %lu samples of the traces\n", idx, this->trace.size());
+				std::exit(EXIT_FAILURE);
+			}
+		}
+		this->poi_trace.resize(this->options.poi.size());
+		this->bivariate_ttest_ptr = new Bivariate_ttest(this->options.poi.size(), this->options.poi.size() - 1);
+	}
+	if (this->options.with_cpa)
+	{
+		if (this->sec_algo.model == nullptr)
+		{
+			fprintf(stderr, "-- ERROR: %s has no leakage model for CPA\n", this->sec_algo.name.c_str());
+			std::exit(EXIT_FAILURE);
+		}
+		this->cpa_ptr = new Cpa(this->trace.size(), this->sec_algo.n_guess);
+		this->hypotheses.resize(this->sec_algo.n_guess);
+	}
+	if (this->options.save_traces)
+	{
+		this->open_trace_files(this->trace.size());
+	}
+}
+
+/* the t-test only accumulates the samples that were not constant during the
+   warm-up. Warm-up traces are replayed once the filter is frozen */
+void Campaign::end_warmup(void)
+{
+	this->sample_filter_ptr->freeze();
+	this->ttest_ptr = new Power_sum_ttest(this->sample_filter_ptr->get_n_kept());
+	if (this->options.t_test_order > 1)
+	{
+		this->moment_ttest_ptr = new Moment_ttest(this->sample_filter_ptr->get_n_kept(), this->options.t_test_order);
+	}
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		for (auto &warmup_trace : this->warmup_traces[cls])
+		{
+			this->update_ttest(static_cast<Input_class>(cls), warmup_trace);
+		}
+		this->warmup_traces[cls].clear();
+		this->warmup_traces[cls].shrink_to_fit();
+	}
+}
+
+void Campaign::update_ttest(Input_class input_class, const std::vector<unsigned int> &vec)
+{
+	unsigned int n_readmitted = this->sample_filter_ptr->compact(vec, this->compact_trace);
+	unsigned int n_kept = this->sample_filter_ptr->get_n_kept();
+
+	/* the buffered traces do not have the readmitted samples */
+	if (n_readmitted > 0)
+	{
+		this->flush_ttest_batch(INPUT_FIXED);
+		this->flush_ttest_batch(INPUT_RANDOM);
+	}
+	for (unsigned int k = n_kept - n_readmitted; k < n_kept; ++k)
+	{
+		this->ttest_ptr->add_constant_sample(this->sample_filter_ptr->get_constant_value(k));
+		if (this->moment_ttest_ptr != nullptr)
+		{
+			this->moment_ttest_ptr->add_constant_sample(this->sample_filter_ptr->get_constant_value(k));
+		}
+	}
+	Trace_batch &batch = this->ttest_batch[(input_class == INPUT_FIXED) ? 0 : 1];
+	batch.add(this->compact_trace);
+	if (batch.get_n_trace() == BATCH_TRACES)
+	{
+		this->flush_ttest_batch(input_class);
+	}
+}
+
+/* identical traces of the batch are accumulated once, with their count as weight */
+void Campaign::flush_ttest_batch(Input_class input_class)
+{
+	Trace_batch &batch = this->ttest_batch[(input_class == INPUT_FIXED) ? 0 : 1];
+
+	if (batch.empty())
+	{
+		return;
+	}
+	if (input_class == INPUT_FIXED)
+	{
+		this->ttest_ptr->update1_batch(batch.get_rows(), batch.get_n_row(), batch.get_weights(), this->sample_pool_ptr);
+	}
+	else
+	{
+		this->ttest_ptr->update2_batch(batch.get_rows(), batch.get_n_row(), batch.get_weights(), this->sample_pool_ptr);
+	}
+	if (this->moment_ttest_ptr != nullptr)
+	{
+		if (input_class == INPUT_FIXED)
+		{
+			this->moment_ttest_ptr->update1_batch(batch.get_rows(), batch.get_n_row(), batch.get_weights(), this->sample_pool_ptr);
+		}
+		else
+		{
+			this->moment_ttest_ptr->update2_batch(batch.get_rows(), batch.get_n_row(), batch.get_weights(), this->sample_pool_ptr);
+		}
+	}
+	batch.clear();
+}
+
+void Campaign::flush_histogram_batch(Input_class input_class)
+{
+	Trace_batch &batch = this->histogram_batch[(input_class == INPUT_FIXED) ? 0 : 1];
+
+	if (batch.empty())
+	{
+		return;
+	}
+	if (input_class == INPUT_FIXED)
+	{
+		this->histogram_test_ptr->update1_batch(batch.get_rows(), batch.get_n_row(), batch.get_weights(), this->sample_pool_ptr);
+	}
+	else
+	{
+		this->histogram_test_ptr->update2_batch(batch.get_rows(), batch.get_n_row(), batch.get_weights(), this->sample_pool_ptr);
+	}
+	batch.clear();
+}
+
+/* the traces buffered by update() and update_ttest() are accumulated before
+   the accumulators are read or saved */
+void Campaign::flush_batches(void)
+{
+	if (this->ttest_ptr != nullptr)
+	{
+		this->flush_ttest_batch(INPUT_FIXED);
+		this->flush_ttest_batch(INPUT_RANDOM);
+	}
+	if (this->histogram_test_ptr != nullptr)
+	{
+		this->flush_histogram_batch(INPUT_FIXED);
+		this->flush_histogram_batch(INPUT_RANDOM);
+	}
+}
+
+/* with points of interest, the test runs on the trace restricted to them */
+void Campaign::update_bivariate(Input_class input_class)
+{
+	const std::vector<unsigned int> *vec = &this->trace;
+
+	if (this->options.poi.size() > 0)
+	{
+		for (unsigned int k = 0; k < this->options.poi.size(); ++k)
+		{
+			this->poi_trace[k] = this->trace[this->options.poi[k]];
+		}
+		vec = &this->poi_trace;
+	}
+	if (input_class == INPUT_FIXED)
+	{
+		this->bivariate_ttest_ptr->update1(*vec);
+	}
+	else
+	{
+		this->bivariate_ttest_ptr->update2(*vec);
+	}
+}
+
+void Campaign::update(Input_class input_class)
+{
+	/* created from the first trace, or the first one after a resume */
+	if (this->options.with_hotspots && this->hotspot_ptr == nullptr)
+	{
+		double threshold = (this->options.stop_threshold > 0.0) ? this->options.stop_threshold : HOTSPOT_THRESHOLD;
+		this->hotspot_ptr = new Hotspot_report(this->cpu.get_pwr_pc_trace(), this->cpu.get_pwr_source_trace(), threshold);
+	}
+	if (this->options.with_alignment)
+	{
+		const std::vector<unsigned int> &ids = this->aligner_ptr->align(this->pc_trace, input_class);
+		if (input_class == INPUT_FIXED)
+		{
+			this->aligned_ttest_ptr->update1(this->trace, ids);
+		}
+		else
+		{
+			this->aligned_ttest_ptr->update2(this->trace, ids);
+		}
+	}
+	else if (this->trace.size() != this->sample_filter_ptr->get_n_sample())
+	{
+		fprintf(stderr, "-- ERROR: trace length changed from %u to %lu samples (input dependent control flow?), use -a\n",
+			this->sample_filter_ptr->get_n_sample(), this->trace.size());
+		std::exit(EXIT_FAILURE);
+	}
+	else if (this->sample_filter_ptr->is_frozen())
+	{
+		this->update_ttest(input_class, this->trace);
+	}
+	else
+	{
+		this->sample_filter_ptr->learn(this->trace);
+		this->warmup_traces[input_class].push_back(this->trace);
+	}
+	if (this->options.with_bit_leakage)
+	{
+		if (input_class == INPUT_FIXED)
+		{
+			this->bit_test_ptr->update1(this->bit_trace);
+		}
+		else
+		{
+			this->bit_test_ptr->update2(this->bit_trace);
+		}
+	}
+	if (this->histogram_test_ptr != nullptr)
+	{
+		Trace_batch &batch = this->histogram_batch[(input_class == INPUT_FIXED) ? 0 : 1];
+		batch.add(this->trace);
+		if (batch.get_n_trace() == BATCH_TRACES)
+		{
+			this->flush_histogram_batch(input_class);
+		}
+	}
+	if (this->bivariate_ttest_ptr != nullptr)
+	{
+		this->update_bivariate(input_class);
+	}
+	/* the key is the same in both classes, but only random inputs carry information */
+	if (this->cpa_ptr != nullptr && input_class == INPUT_RANDOM)
+	{
+		this->sec_algo.model(this->inputs.data(), this->hypotheses.data());
+		this->cpa_ptr->update(this->trace, this->hypotheses);
+	}
+	if (this->conditional_histogram_ptr != nullptr && input_class == INPUT_RANDOM)
+	{
+		this->conditional_histogram_ptr->update(this->trace, this->sec_algo.intermediate(this->inputs.data()));
+	}
+	if (this->template_builder_ptr != nullptr && input_class == INPUT_RANDOM)
+	{
+		for (unsigned int k = 0; k < this->options.template_poi.size(); ++k)
+		{
+			this->template_trace[k] = this->trace[this->options.template_poi[k]];
+		}
+		this->template_builder_ptr->update(this->template_trace, this->sec_algo.intermediate(this->inputs.data()));
+	}
+	if (this->anova_ptr != nullptr && input_class == INPUT_RANDOM)
+	{
+		unsigned int value = this->sec_algo.intermediate(this->inputs.data());
+		this->anova_ptr->update(this->trace, (this->options.anova_classes == ANOVA_HW) ? __builtin_popcount(value) : value);
+	}
+}
+
+/* Control tests on the full traces: fixed-vs-fixed between the two fixed
+   inputs, and random-vs-random between the random traces of even and odd
+   measures. They should not detect anything on a sound setup */
+void Campaign::update_control(unsigned long int measure_idx, Input_class input_class)
+{
+	if (input_class == INPUT_FIXED)
+	{
+		this->fvf_ttest_ptr->update1(this->trace);
+	}
+	else if (input_class == INPUT_FIXED_2)
+	{
+		this->fvf_ttest_ptr->update2(this->trace);
+	}
+	else if (measure_idx % 2 == 0)
+	{
+		this->rvr_ttest_ptr->update1(this->trace);
+	}
+	else
+	{
+		this->rvr_ttest_ptr->update2(this->trace);
+	}
+}
+
+/* t_test_fvf.npy and t_test_rvr.npy, the max |t| of the three tests being
+   printed together */
+void Campaign::save_control(void)
+{
+	std::vector<std::vector<double>> t;
+
+	t.push_back(this->ttest_ptr->t_test());
+	t.push_back(this->fvf_ttest_ptr->t_test());
+	t.push_back(this->rvr_ttest_ptr->t_test());
+	save_npy(this->output_filename("fvf"), t[1]);
+	save_npy(this->output_filename("rvr"), t[2]);
+
+	std::vector<double> max = this->max_abs_t(t);
+	printf("-- max |t|: fixed-vs-random %.2f, fixed-vs-fixed %.2f, random-vs-random %.2f\n", max[0], max[1], max[2]);
+}
+
+/* t_test_bivariate.npy is a (n_sample, window) map, [i, d - 1] being the pair
+   (i, i + d), or a symmetric (n_poi, n_poi) map with points of interest */
+void Campaign::save_bivariate(void)
+{
+	std::vector<double> t = this->bivariate_ttest_ptr->t_test();
+	unsigned int n_col = this->bivariate_ttest_ptr->get_window();
+
+	if (this->options.poi.size() > 0)
+	{
+		unsigned int n_poi = this->options.poi.size();
+		std::vector<double> t_map(n_poi*n_poi, 0.0);
+		for (unsigned int a = 0; a < n_poi; ++a)
+		{
+			for (unsigned int b = a + 1; b < n_poi; ++b)
+			{
+				t_map[a*n_poi + b] = t[a*n_col + b - a - 1];
+				t_map[b*n_poi + a] = t[a*n_col + b - a - 1];
+			}
+		}
+		t.swap(t_map);
+		n_col = n_poi;
+	}
+	save_npy(this->output_filename("bivariate"), t, n_col);
+}
+
+/* at the end of the campaign, the accumulators of the compacted traces are
+   brought back to the full traces, where dropped samples are constant */
+void Campaign::to_full_trace(void)
+{
+	const std::vector<unsigned int> &remap = this->sample_filter_ptr->get_remap();
+	const std::vector<unsigned int> &constant_value = this->sample_filter_ptr->get_constant_values();
+
+	this->flush_batches();
+	this->ttest_ptr->expand(remap, constant_value);
+	if (this->moment_ttest_ptr != nullptr)
+	{
+		this->moment_ttest_ptr->expand(remap, constant_value);
+	}
+}
+
+/* options the accumulators depend on: states saved with other values can not
+   be merged or resumed */
+void Campaign::write_settings(State_writer &writer) const
+{
+	writer.write_tag(this->sec_algo.name);
+	writer.write_u64(this->options.with_pipeline_leakage);
+	writer.write_f64(this->options.noise_sigma);
+	writer.write(this->options.fir_taps);
+	writer.write_u64(this->options.decimation);
+	writer.write_f64(this->options.adc_gain);
+	writer.write_u64(this->options.t_test_order);
+	writer.write_u64(this->options.with_bit_leakage);
+	writer.write_u64(this->options.bivariate_window);
+	writer.write(std::vector<uint32_t>(this->options.poi.begin(), this->options.poi.end()));
+	writer.write_u64(this->options.with_cpa);
+	writer.write_u64(this->options.with_histogram);
+	writer.write_u64(this->options.with_information);
+	writer.write_u64(this->options.with_control);
+	writer.write_u64(this->options.anova_classes);
+	writer.write(std::vector<uint32_t>(this->options.template_poi.begin(), this->options.template_poi.end()));
+}
+
+void Campaign::check_settings(State_reader &reader) const
+{
+	std::vector<double> fir_taps;
+	std::vector<uint32_t> poi;
+	std::vector<uint32_t> template_poi;
+	bool same = true;
+
+	reader.read_tag(this->sec_algo.name);
+	same &= (reader.read_u64() == this->options.with_pipeline_leakage);
+	same &= (reader.read_f64() == this->options.noise_sigma);
+	reader.read(fir_taps);
+	same &= (fir_taps == this->options.fir_taps);
+	same &= (reader.read_u64() == this->options.decimation);
+	same &= (reader.read_f64() == this->options.adc_gain);
+	same &= (reader.read_u64() == this->options.t_test_order);
+	same &= (reader.read_u64() == this->options.with_bit_leakage);
+	same &= (reader.read_u64() == this->options.bivariate_window);
+	reader.read(poi);
+	same &= (poi.size() == this->options.poi.size() && std::equal(poi.begin(), poi.end(), this->options.poi.begin()));
+	same &= (reader.read_u64() == this->options.with_cpa);
+	same &= (reader.read_u64() == this->options.with_histogram);
+	same &= (reader.read_u64() == this->options.with_information);
+	same &= (reader.read_u64() == this->options.with_control);
+	same &= (reader.read_u64() == this->options.anova_classes);
+	reader.read(template_poi);
+	same &= (template_poi.size() == this->options.template_poi.size() &&
+		std::equal(template_poi.begin(), template_poi.end(), this->options.template_poi.begin()));
+	if (!same)
+	{
+		fprintf(stderr, "-- ERROR: %s was saved with other -p, -N, -F, -D, -G, -d, -b, -W, -P, -K, -H, -I, -T, -x or -A options\n", reader.get_filename().c_str());
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+void Campaign::save_accumulators(State_writer &writer)
+{
+	this->flush_batches();
+	this->ttest_ptr->save(writer);
+	if (this->moment_ttest_ptr != nullptr)
+	{
+		this->moment_ttest_ptr->save(writer);
+	}
+	if (this->bit_test_ptr != nullptr)
+	{
+		this->bit_test_ptr->save(writer);
+	}
+	if (this->histogram_test_ptr != nullptr)
+	{
+		this->histogram_test_ptr->save(writer);
+	}
+	if (this->bivariate_ttest_ptr != nullptr)
+	{
+		this->bivariate_ttest_ptr->save(writer);
+	}
+	if (this->cpa_ptr != nullptr)
+	{
+		this->cpa_ptr->save(writer);
+	}
+	if (this->conditional_histogram_ptr != nullptr)
+	{
+		this->conditional_histogram_ptr->save(writer);
+	}
+	if (this->template_builder_ptr != nullptr)
+	{
+		this->template_builder_ptr->save(writer);
+	}
+	if (this->fvf_ttest_ptr != nullptr)
+	{
+		this->fvf_ttest_ptr->save(writer);
+		this->rvr_ttest_ptr->save(writer);
+	}
+	if (this->anova_ptr != nullptr)
+	{
+		this->anova_ptr->save(writer);
+	}
+}
+
+/* The state holds the accumulators enabled by the options, in full trace
+   coordinates, so that runs with the same options can be merged whatever
+   samples their warm-up dropped */
+void Campaign::save_state(std::string filename)
+{
+	State_writer writer(filename);
+
+	writer.write_tag("Campaign");
+	this->write_settings(writer);
+	this->save_accumulators(writer);
+	writer.close();
+}
+
+void Campaign::merge_state(std::string filename)
+{
+	State_reader reader(filename);
+
+	reader.read_tag("Campaign");
+	this->check_settings(reader);
+
+	Power_sum_ttest ttest(0);
+	ttest.load(reader);
+	this->ttest_ptr->merge(ttest);
+	if (this->moment_ttest_ptr != nullptr)
+	{
+		Moment_ttest moment_ttest(0, 1);
+		moment_ttest.load(reader);
+		this->moment_ttest_ptr->merge(moment_ttest);
+	}
+	if (this->bit_test_ptr != nullptr)
+	{
+		Bit_test bit_test(0);
+		bit_test.load(reader);
+		this->bit_test_ptr->merge(bit_test);
+	}
+	if (this->histogram_test_ptr != nullptr)
+	{
+		Histogram_test histogram_test(0, 0);
+		histogram_test.load(reader);
+		this->histogram_test_ptr->merge(histogram_test);
+	}
+	if (this->bivariate_ttest_ptr != nullptr)
+	{
+		Bivariate_ttest bivariate_ttest(0, 1);
+		bivariate_ttest.load(reader);
+		this->bivariate_ttest_ptr->merge(bivariate_ttest);
+	}
+	if (this->cpa_ptr != nullptr)
+	{
+		Cpa cpa(0, 0);
+		cpa.load(reader);
+		this->cpa_ptr->merge(cpa);
+	}
+	if (this->conditional_histogram_ptr != nullptr)
+	{
+		Conditional_histogram conditional_histogram(0, 0, 0);
+		conditional_histogram.load(reader);
+		this->conditional_histogram_ptr->merge(conditional_histogram);
+	}
+	if (this->template_builder_ptr != nullptr)
+	{
+		Template_builder template_builder(0, 0);
+		template_builder.load(reader);
+		this->template_builder_ptr->merge(template_builder);
+	}
+	if (this->fvf_ttest_ptr != nullptr)
+	{
+		Power_sum_ttest control_ttest(0);
+		control_ttest.load(reader);
+		this->fvf_ttest_ptr->merge(control_ttest);
+		control_ttest.load(reader);
+		this->rvr_ttest_ptr->merge(control_ttest);
+	}
+	if (this->anova_ptr != nullptr)
+	{
+		Anova anova(0, 0);
+		anova.load(reader);
+		this->anova_ptr->merge(anova);
+	}
+}
+
+/* A checkpoint holds everything the next measures depend on: the generator
+   of the inputs (its full state, i.e. its position in the stream), the seed
+   of the noise, the cpu and its memory, the sample filter and the
+   accumulators. Checkpoints are only taken after the warm-up */
+void Campaign::save_checkpoint(unsigned long int n_done)
+{
+	State_writer writer(this->output_filename("checkpoint", ".bin"));
+	std::ostringstream rnd_state;
+
+	rnd_state << this->rnd_gen_uint32;
+	writer.write_tag("Checkpoint");
+	this->write_settings(writer);
+	writer.write_u64(this->options.n_measure);
+	writer.write_u64(n_done);
+	writer.write_string(rnd_state.str());
+	writer.write_u64(this->scope.get_seed());
+	this->cpu.save(writer);
+	this->sample_filter_ptr->save(writer);
+	this->save_accumulators(writer);
+	writer.write(this->convergence);
+	writer.write_u64(this->n_over_threshold);
+	writer.write(this->cpa_curve);
+	writer.write_u64(this->hotspot_ptr != nullptr);
+	if (this->hotspot_ptr != nullptr)
+	{
+		this->hotspot_ptr->save(writer);
+	}
+	writer.close();
+}
+
+/* returns the number of measures already done. With -E the campaign is
+   extended, otherwise it goes on to the number of measures it was started with */
+unsigned long int Campaign::load_checkpoint(void)
+{
+	State_reader reader(this->output_filename("checkpoint", ".bin"));
+	std::istringstream rnd_state;
+
+	reader.read_tag("Checkpoint");
+	this->check_settings(reader);
+	unsigned long int n_measure = reader.read_u64();
+	unsigned long int n_done = reader.read_u64();
+	this->options.n_measure = (this->options.n_extend > 0) ? n_done + this->options.n_extend : n_measure;
+	rnd_state.str(reader.read_string());
+	rnd_state >> this->rnd_gen_uint32;
+	this->scope.set_seed(reader.read_u64());
+	this->cpu.load(reader);
+
+	this->sample_filter_ptr = new Sample_filter(0);
+	this->sample_filter_ptr->load(reader);
+	this->ttest_ptr = new Power_sum_ttest(0);
+	this->ttest_ptr->load(reader);
+	if (this->options.t_test_order > 1)
+	{
+		this->moment_ttest_ptr = new Moment_ttest(0, 1);
+		this->moment_ttest_ptr->load(reader);
+	}
+	if (this->options.with_bit_leakage)
+	{
+		this->bit_test_ptr = new Bit_test(0);
+		this->bit_test_ptr->load(reader);
+	}
+	if (this->options.with_histogram)
+	{
+		this->histogram_test_ptr = new Histogram_test(0, 0);
+		this->histogram_test_ptr->load(reader);
+	}
+	if (this->options.bivariate_window > 0 || this->options.poi.size() > 0)
+	{
+		this->bivariate_ttest_ptr = new Bivariate_ttest(0, 1);
+		this->bivariate_ttest_ptr->load(reader);
+		this->poi_trace.resize(this->options.poi.size());
+	}
+	if (this->options.with_cpa)
+	{
+		this->cpa_ptr = new Cpa(0, 0);
+		this->cpa_ptr->load(reader);
+		this->hypotheses.resize(this->cpa_ptr->get_n_guess());
+	}
+	if (this->options.with_information)
+	{
+		this->conditional_histogram_ptr = new Conditional_histogram(0, 0, 0);
+		this->conditional_histogram_ptr->load(reader);
+	}
+	if (this->options.template_poi.size() > 0)
+	{
+		this->template_builder_ptr = new Template_builder(0, 0);
+		this->template_builder_ptr->load(reader);
+		this->template_trace.resize(this->options.template_poi.size());
+	}
+	if (this->options.with_control)
+	{
+		this->fvf_ttest_ptr = new Power_sum_ttest(0);
+		this->fvf_ttest_ptr->load(reader);
+		this->rvr_ttest_ptr = new Power_sum_ttest(0);
+		this->rvr_ttest_ptr->load(reader);
+	}
+	if (this->options.anova_classes != ANOVA_NONE)
+	{
+		this->anova_ptr = new Anova(0, 0);
+		this->anova_ptr->load(reader);
+	}
+	reader.read(this->convergence);
+	this->n_over_threshold = reader.read_u64();
+	reader.read(this->cpa_curve);
+	if (reader.read_u64())
+	{
+		Hotspot_report *hotspot_ptr = new Hotspot_report({}, {}, 0.0);
+		hotspot_ptr->load(reader);
+		if (this->options.with_hotspots)
+		{
+			this->hotspot_ptr = hotspot_ptr;
+		}
+		else
+		{
+			delete hotspot_ptr;
+		}
+	}
+	this->sample_pool_ptr = (this->options.n_thread > 1) ? new Sample_pool(this->options.n_thread) : nullptr;
+	this->initialized = true;
+	return n_done;
+}
+
+/* smallest round(10^(k/points_per_decade)) above n. The t statistic of a few
+   traces has heavy tails, so the curve starts at MIN_CONVERGENCE_POINT */
+static unsigned long int next_convergence_point(unsigned long int n, unsigned int points_per_decade)
+{
+	unsigned long int k = (n < MIN_CONVERGENCE_POINT) ? 0 : static_cast<unsigned long int>(log10(n)*points_per_decade);
+
+	while (true)
+	{
+		unsigned long int point = llround(pow(10.0, static_cast<double>(k)/points_per_decade));
+		if (point > n && point >= MIN_CONVERGENCE_POINT)
+		{
+			return point;
+		}
+		++k;
+	}
+}
+
+/* n and one max |t| per test, see max_abs_t() */
+unsigned int Campaign::get_n_convergence_col(void) const
+{
+	unsigned int n_col = 2 + (this->options.t_test_order - 1);
+
+	if (this->options.with_bit_leakage)
+	{
+		n_col++;
+	}
+	if (this->options.bivariate_window > 0 || this->options.poi.size() > 0)
+	{
+		n_col++;
+	}
+	return n_col;
+}
+
+/* t-tests in the coordinates of the accumulators: the first-order t-test,
+   the higher orders (-d), the bit t-test (-b) and the bivariate t-test (-W,
+   -P), in this order */
+std::vector<std::vector<double>> Campaign::t_tests(void)
+{
+	std::vector<std::vector<double>> t;
+
+	this->flush_batches();
+	if (this->options.with_alignment)
+	{
+		t.push_back(this->aligned_ttest_ptr->t_test());
+	}
+	else
+	{
+		t.push_back(this->ttest_ptr->t_test());
+	}
+	for (unsigned int order = 2; order <= this->options.t_test_order; ++order)
+	{
+		t.push_back(this->moment_ttest_ptr->t_test(order));
+	}
+	if (this->bit_test_ptr != nullptr)
+	{
+		t.push_back(this->bit_test_ptr->t_test());
+	}
+	if (this->bivariate_ttest_ptr != nullptr)
+	{
+		t.push_back(this->bivariate_ttest_ptr->t_test());
+	}
+	return t;
+}
+
+/* max |t| of each test of t_tests() */
+std::vector<double> Campaign::max_abs_t(const std::vector<std::vector<double>> &t) const
+{
+	std::vector<double> max;
+
+	for (auto &vec : t)
+	{
+		double m = 0.0;
+		for (auto x : vec)
+		{
+			m = (fabs(x) > m) ? fabs(x) : m;
+		}
+		max.push_back(m);
+	}
+	return max;
+}
+
+/* Adds a point to the convergence curve. Returns true when the campaign can
+   stop: max |t| of any test above the threshold at this point and at the
+   previous one */
+bool Campaign::track_convergence(unsigned long int n_done, const std::vector<std::vector<double>> &t)
+{
+	std::vector<double> max = this->max_abs_t(t);
+	bool over = false;
+
+	this->convergence.push_back(n_done);
+	for (auto m : max)
+	{
+		this->convergence.push_back(m);
+		over |= (m > this->options.stop_threshold);
+	}
+	this->n_over_threshold = over ? this->n_over_threshold + 1 : 0;
+	return (this->options.stop_threshold > 0.0 && this->n_over_threshold >= 2);
+}
+
+/* first crossings of the univariate t-tests, brought back to the full traces */
+void Campaign::track_hotspots(unsigned long int n_done, const std::vector<std::vector<double>> &t)
+{
+	std::vector<std::vector<double>> full;
+
+	for (unsigned int k = 0; k < this->options.t_test_order; ++k)
+	{
+		full.push_back(this->sample_filter_ptr->expand(t[k]));
+	}
+	this->hotspot_ptr->track(n_done, full);
+}
+
+/* t_test_hotspots.txt and t_test_hotspots.json rank the (instruction, source
+   register) pairs by max |t|. The instructions come from the listing of the
+   firmware (<name>.lst, written by the firmware build) when it exists, else
+   they are given by their encoding */
+void Campaign::save_hotspots(void)
+{
+	std::map<uint32_t, std::string> disassembly = read_listing(this->sec_algo.name + ".lst");
+	std::vector<std::vector<double>> t;
+
+	for (auto pc : this->hotspot_ptr->get_pc_trace())
+	{
+		/* writing LR before the call is attributed to the return address */
+		if (disassembly.find(pc) == disassembly.end() && pc > this->options.mem_size - 4)
+		{
+			disassembly[pc] = "-";
+		}
+		else if (disassembly.find(pc) == disassembly.end())
+		{
+			uint16_t ins16 = this->cpu.read8_ram(pc) | (this->cpu.read8_ram(pc + 1) << 8);
+			char encoding[16];
+			/* same test as the decoder of the cpu */
+			if ((ins16 & OP16_MASK) == OP16_VAL1 || (ins16 & OP16_MASK) == OP16_VAL2 || (ins16 & OP16_MASK) == OP16_VAL3)
+			{
+				uint16_t ins16_b = this->cpu.read8_ram(pc + 2) | (this->cpu.read8_ram(pc + 3) << 8);
+				snprintf(encoding, sizeof(encoding), "%04x %04x", ins16, ins16_b);
+			}
+			else
+			{
+				snprintf(encoding, sizeof(encoding), "%04x", ins16);
+			}
+			disassembly[pc] = encoding;
+		}
+	}
+	t.push_back(this->ttest_ptr->t_test());
+	for (unsigned int order = 2; order <= this->options.t_test_order; ++order)
+	{
+		t.push_back(this->moment_ttest_ptr->t_test(order));
+	}
+	this->hotspot_ptr->write(this->output_filename("hotspots", ".txt"), this->output_filename("hotspots", ".json"),
+		this->sec_algo.name, this->options.n_measure, t, disassembly);
+}
+
+/* t_test_<prefix>sparse.json lists the samples over the threshold with their
+   pc and source, t_test_<prefix>envelope.npy holds the min/max envelope */
+void Campaign::save_sparse(std::string prefix, const std::vector<double> &t)
+{
+	double threshold = (this->options.stop_threshold > 0.0) ? this->options.stop_threshold : HOTSPOT_THRESHOLD;
+
+	save_sparse_ttest(this->output_filename(prefix + "sparse", ".json"), this->output_filename(prefix + "envelope"), t,
+		threshold, this->options.sparse_buckets, this->trace_cpu_ptr->get_pwr_pc_trace(), this->trace_cpu_ptr->get_pwr_source_trace());
+}
+
+/* Adds a point to the success curve of the CPA. The attack succeeds when the
+   rank of the correct guess is 0 */
+void Campaign::track_cpa(unsigned long int n_done)
+{
+	std::vector<double> rho = this->cpa_ptr->correlation();
+	unsigned int n_sample = this->cpa_ptr->get_n_sample();
+	double peak_correct = 0.0;
+	double peak_other = 0.0;
+
+	for (unsigned int g = 0; g < this->cpa_ptr->get_n_guess(); ++g)
+	{
+		double &peak = (g == this->sec_algo.correct_guess) ? peak_correct : peak_other;
+		for (unsigned int i = 0; i < n_sample; ++i)
+		{
+			peak = (rho[static_cast<unsigned long int>(g)*n_sample + i] > peak) ? rho[static_cast<unsigned long int>(g)*n_sample + i] : peak;
+		}
+	}
+	this->cpa_curve.push_back(n_done);
+	this->cpa_curve.push_back(this->cpa_ptr->rank(rho, this->sec_algo.correct_guess));
+	this->cpa_curve.push_back(peak_correct);
+	this->cpa_curve.push_back(peak_other);
+}
+
+/* t_test_cpa.npy is the (n_guess, n_sample) correlation matrix,
+   t_test_cpa_rank.npy the success curve */
+void Campaign::save_cpa(void)
+{
+	std::vector<double> rho = this->cpa_ptr->correlation();
+
+	if (this->cpa_curve.empty() || this->cpa_curve[this->cpa_curve.size() - 4] != this->options.n_measure)
+	{
+		this->track_cpa(this->options.n_measure);
+	}
+	save_npy(this->output_filename("cpa"), rho, this->cpa_ptr->get_n_sample());
+	save_npy(this->output_filename("cpa_rank"), this->cpa_curve, 4);
+	printf("-- CPA: rank of the correct guess 0x%x after %lu measurements: %.0f\n", this->sec_algo.correct_guess,
+		this->options.n_measure, this->cpa_curve[this->cpa_curve.size() - 3]);
+}
+
+/* t_test_template_means.npy is the (n_value, n_poi) matrix of the class
+   means, t_test_template_cov.npy the (n_poi, n_poi) pooled covariance and
+   t_test_template_counts.npy the number of traces of each class */
+void Campaign::save_templates(void)
+{
+	unsigned int n_poi = this->template_builder_ptr->get_n_poi();
+
+	save_npy(this->output_filename("template_means"), this->template_builder_ptr->means(), n_poi);
+	save_npy(this->output_filename("template_cov"), this->template_builder_ptr->pooled_covariance(), n_poi);
+	save_npy(this->output_filename("template_counts"), this->template_builder_ptr->counts());
+}
+
+/* the campaign ends after n_done measures */
+void Campaign::stop(unsigned long int n_done)
+{
+	printf("\n-- leakage confirmed after %lu measurements, stopping\n", n_done);
+	this->options.n_measure = n_done;
+	if (this->options.save_traces)
+	{
+		this->trace_npy_ptr->truncate(this->n_trace_per_measure*n_done);
+		this->label_npy_ptr->truncate(this->n_trace_per_measure*n_done);
+		this->input_npy_ptr->truncate(this->n_trace_per_measure*n_done);
+		if (this->bit_trace_npy_ptr != nullptr)
+		{
+			this->bit_trace_npy_ptr->truncate(this->n_trace_per_measure*n_done);
+		}
+	}
+}
+
+void Campaign::save_results(void)
+{
+	if (this->options.with_alignment)
+	{
+		/* t_test_keys.npy gives the (pc, occurrence, event) of each sample */
+		const std::vector<uint32_t> &keys = this->aligner_ptr->get_keys();
+		Npy_matrix key_npy(this->output_filename("keys"), "<u4", this->aligner_ptr->get_n_sample(), 3);
+		memcpy(key_npy.row(0), keys.data(), sizeof(uint32_t)*keys.size());
+		save_npy(this->options.t_test_filename, this->aligned_ttest_ptr->t_test());
+		this->aligner_ptr->report(this->output_filename("paths", ".txt"));
+		return;
+	}
+	if (!this->sample_filter_ptr->is_frozen())
+	{
+		this->end_warmup();
+	}
+	this->to_full_trace();
+	for (auto &filename : this->options.merge_filenames)
+	{
+		this->merge_state(filename);
+	}
+	if (this->options.state_filename != "")
+	{
+		this->save_state(this->options.state_filename);
+	}
+	/* the merged states count in the correlation and the last point of the success curve */
+	if (this->cpa_ptr != nullptr)
+	{
+		this->save_cpa();
+	}
+	std::vector<double> t = this->ttest_ptr->t_test();
+	save_npy(this->options.t_test_filename, t);
+	if (this->options.sparse_buckets > 0)
+	{
+		this->save_sparse("", t);
+	}
+	if (this->fvf_ttest_ptr != nullptr)
+	{
+		this->save_control();
+	}
+	for (unsigned int order = 2; order <= this->options.t_test_order; ++order)
+	{
+		std::vector<double> t_order = this->moment_ttest_ptr->t_test(order);
+		save_npy(this->output_filename("order" + std::to_string(order)), t_order);
+		if (this->options.sparse_buckets > 0)
+		{
+			this->save_sparse("order" + std::to_string(order) + "_", t_order);
+		}
+	}
+	if (this->options.with_bit_leakage)
+	{
+		save_npy(this->output_filename("bit"), this->bit_test_ptr->t_test(), 32);
+		save_npy(this->output_filename("bit_chi2"), this->bit_test_ptr->chi2_test(), 32);
+	}
+	if (this->histogram_test_ptr != nullptr)
+	{
+		save_npy(this->output_filename("chi2"), this->histogram_test_ptr->chi2_test());
+	}
+	if (this->conditional_histogram_ptr != nullptr)
+	{
+		save_npy(this->output_filename("snr"), this->conditional_histogram_ptr->snr());
+		save_npy(this->output_filename("mi"), this->conditional_histogram_ptr->mutual_information());
+	}
+	if (this->template_builder_ptr != nullptr)
+	{
+		this->save_templates();
+	}
+	if (this->hotspot_ptr != nullptr)
+	{
+		this->save_hotspots();
+	}
+	if (this->anova_ptr != nullptr)
+	{
+		/* degrees of freedom (k - 1, n - k) */
+		save_npy(this->output_filename("anova"), this->anova_ptr->f_test());
+		printf("-- ANOVA: %u classes, %lu traces\n", this->anova_ptr->get_n_class_seen(), this->anova_ptr->get_n());
+	}
+	if (this->bivariate_ttest_ptr != nullptr)
+	{
+		this->save_bivariate();
+	}
+}
+
+unsigned long int Campaign::get_n_batch(void) const
+{
+	return (this->options.n_measure + WORKER_BATCH - 1)/WORKER_BATCH;
+}
+
+/* A batch of -J and -L only depends on its index: its inputs come from a
+   generator seeded with (batch_seed, index), the cpu starts from the freshly
+   loaded firmware and the noise only depends on the index of the trace */
+void Campaign::start_batch(Campaign &master, Cpu &initial_cpu, unsigned long int batch_idx)
+{
+	std::seed_seq seed{static_cast<uint32_t>(master.batch_seed), static_cast<uint32_t>(master.batch_seed >> 32),
+		static_cast<uint32_t>(batch_idx), static_cast<uint32_t>(batch_idx >> 32)};
+
+	this->rnd_gen_uint32.seed(seed);
+	this->scope.set_seed(master.scope.get_seed());
+	this->cpu.copy_state(initial_cpu);
+}
+
+/* worker side of -J: pulls batches of measures until all of them are taken */
+void Campaign::run_batches(Campaign &master, std::atomic<unsigned long int> &next_batch, Progress_bar &progress_bar)
+{
+	Cpu initial_cpu(this->options);
+
+	this->sec_algo.load(&initial_cpu);
+	initial_cpu.reset();
+	for (unsigned long int batch_idx = next_batch++; batch_idx < this->get_n_batch(); batch_idx = next_batch++)
+	{
+		unsigned long int first_measure = batch_idx*WORKER_BATCH;
+		unsigned long int last_measure = std::min(first_measure + WORKER_BATCH, this->options.n_measure);
+
+		this->start_batch(master, initial_cpu, batch_idx);
+		for (unsigned long int measure_idx = first_measure; measure_idx < last_measure; ++measure_idx)
+		{
+			this->simulate(measure_idx);
+		}
+		master.end_batch(*this, batch_idx, last_measure - first_measure, progress_bar);
+	}
+}
+
+/* master side of -J and -L, called by a worker after each batch. Moments are not
+   exact sums: those of each batch are handed over and merged in batch order */
+void Campaign::end_batch(Campaign &worker, unsigned long int batch_idx, unsigned long int n_done, Progress_bar &progress_bar)
+{
+	Moment_ttest *moment_ttest_ptr = worker.moment_ttest_ptr;
+
+	if (moment_ttest_ptr != nullptr)
+	{
+		worker.flush_batches();
+		worker.moment_ttest_ptr = new Moment_ttest(worker.sample_filter_ptr->get_n_kept(), this->options.t_test_order);
+	}
+
+	std::lock_guard<std::mutex> lock(this->worker_mutex);
+	if (!this->initialized)
+	{
+		this->trace.resize(worker.trace.size());
+		this->bit_trace.resize(worker.bit_trace.size());
+		this->init();
+	}
+	if (moment_ttest_ptr != nullptr)
+	{
+		this->pending_moments[batch_idx] = moment_ttest_ptr;
+		for (auto it = this->pending_moments.find(this->next_moment_batch); it != this->pending_moments.end();
+			it = this->pending_moments.find(this->next_moment_batch))
+		{
+			this->moment_ttest_ptr->merge(*it->second);
+			delete it->second;
+			this->pending_moments.erase(it);
+			++this->next_moment_batch;
+		}
+	}
+	progress_bar += n_done;
+}
+
+/* the other accumulators are exact sums, merged in worker order */
+void Campaign::merge_worker(Campaign &worker)
+{
+	worker.flush_batches();
+	this->ttest_ptr->merge(*worker.ttest_ptr);
+	if (this->bit_test_ptr != nullptr)
+	{
+		this->bit_test_ptr->merge(*worker.bit_test_ptr);
+	}
+	if (this->histogram_test_ptr != nullptr)
+	{
+		this->histogram_test_ptr->merge(*worker.histogram_test_ptr);
+	}
+	if (this->bivariate_ttest_ptr != nullptr)
+	{
+		this->bivariate_ttest_ptr->merge(*worker.bivariate_ttest_ptr);
+	}
+	if (this->cpa_ptr != nullptr)
+	{
+		this->cpa_ptr->merge(*worker.cpa_ptr);
+	}
+	if (this->conditional_histogram_ptr != nullptr)
+	{
+		this->conditional_histogram_ptr->merge(*worker.conditional_histogram_ptr);
+	}
+	if (this->template_builder_ptr != nullptr)
+	{
+		this->template_builder_ptr->merge(*worker.template_builder_ptr);
+	}
+	if (this->fvf_ttest_ptr != nullptr)
+	{
+		this->fvf_ttest_ptr->merge(*worker.fvf_ttest_ptr);
+		this->rvr_ttest_ptr->merge(*worker.rvr_ttest_ptr);
+	}
+	if (this->anova_ptr != nullptr)
+	{
+		this->anova_ptr->merge(*worker.anova_ptr);
+	}
+}
+
+/* workers left without a batch have no accumulators */
+void Campaign::save_worker_results(const std::vector<Campaign *> &workers, Cpu *trace_cpu_ptr)
+{
+	for (auto worker : workers)
+	{
+		if (worker->initialized)
+		{
+			this->merge_worker(*worker);
+		}
+	}
+	this->trace_cpu_ptr = trace_cpu_ptr;
+	this->save_results();
+	this->trace_cpu_ptr = &this->cpu;
+}
+
+/* -J: n_worker threads, each with its own cpu, input generator and
+   accumulators, simulate batches of measures. The samples of the workers
+   must be the same, so the warm-up is skipped and the traces are kept whole.
+   The results do not depend on which worker ran which batch */
+void Campaign::run_workers(void)
+{
+	std::vector<Campaign *> workers;
+	std::vector<std::thread> threads;
+	std::atomic<unsigned long int> next_batch(0);
+
+	this->options.n_warmup = 0;
+	for (unsigned int k = 0; k < this->options.n_worker; ++k)
+	{
+		workers.push_back(new Campaign(this->options, this->sec_algo));
+	}
+
+	Progress_bar progress_bar(this->options.n_measure, std::cout, "Simulating " + this->sec_algo.name + " with "
+		+ std::to_string(this->options.n_worker) + " workers ...\n");
+	for (auto worker : workers)
+	{
+		threads.push_back(std::thread(&Campaign::run_batches, worker, std::ref(*this), std::ref(next_batch), std::ref(progress_bar)));
+	}
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	/* any worker gives the pc and source of the samples (no -a) */
+	Cpu *trace_cpu_ptr = &this->cpu;
+	for (auto worker : workers)
+	{
+		trace_cpu_ptr = worker->trace.empty() ? trace_cpu_ptr : &worker->cpu;
+	}
+	this->save_worker_results(workers, trace_cpu_ptr);
+	for (auto worker : workers)
+	{
+		delete worker;
+	}
+}
+
+/* producer side of -L: simulates the batches into blocks of traces */
+void Campaign::produce_blocks(Campaign &master, std::atomic<unsigned long int> &next_batch, Trace_ring &ring, Trace_ring &free_ring)
+{
+	Cpu initial_cpu(this->options);
+
+	this->sec_algo.load(&initial_cpu);
+	initial_cpu.reset();
+	for (unsigned long int batch_idx = next_batch++; batch_idx < this->get_n_batch(); batch_idx = next_batch++)
+	{
+		Trace_block *block;
+		if (!free_ring.try_pop(block))
+		{
+			block = new Trace_block;
+		}
+		block->batch_idx = batch_idx;
+		block->first_measure = batch_idx*WORKER_BATCH;
+		block->n_measure = std::min(block->first_measure + WORKER_BATCH, this->options.n_measure) - block->first_measure;
+		block->samples.clear();
+		block->bit_samples.clear();
+		block->inputs.clear();
+
+		this->start_batch(master, initial_cpu, batch_idx);
+		for (unsigned long int measure_idx = block->first_measure; measure_idx < block->first_measure + block->n_measure; ++measure_idx)
+		{
+			for (unsigned int cls = 0; cls < this->n_trace_per_measure; ++cls)
+			{
+				this->acquire(measure_idx, static_cast<Input_class>(cls));
+				block->n_sample = this->trace.size();
+				block->n_bit_sample = this->bit_trace.size();
+				block->samples.insert(block->samples.end(), this->trace.begin(), this->trace.end());
+				block->bit_samples.insert(block->bit_samples.end(), this->bit_trace.begin(), this->bit_trace.end());
+				block->inputs.insert(block->inputs.end(), this->inputs.begin(), this->inputs.end());
+			}
+		}
+		ring.push(block);
+	}
+}
+
+/* consumer side of -L: runs the blocks through its accumulators until it
+   pops the nullptr pushed once all the blocks are produced */
+void Campaign::consume_blocks(Campaign &master, Trace_ring &ring, Trace_ring &free_ring, Progress_bar &progress_bar)
+{
+	unsigned int n_input = this->sec_algo.n_input;
+
+	for (Trace_block *block = ring.pop(); block != nullptr; block = ring.pop())
+	{
+		unsigned long int row_idx = 0;
+		for (unsigned long int measure_idx = block->first_measure; measure_idx < block->first_measure + block->n_measure; ++measure_idx)
+		{
+			for (unsigned int cls = 0; cls < this->n_trace_per_measure; ++cls, ++row_idx)
+			{
+				const uint8_t *samples = block->samples.data() + row_idx*block->n_sample;
+				const uint32_t *bit_samples = block->bit_samples.data() + row_idx*block->n_bit_sample;
+				const uint32_t *inputs = block->inputs.data() + row_idx*n_input;
+				this->trace.assign(samples, samples + block->n_sample);
+				this->bit_trace.assign(bit_samples, bit_samples + block->n_bit_sample);
+				this->inputs.assign(inputs, inputs + n_input);
+				this->accumulate(measure_idx, static_cast<Input_class>(cls));
+			}
+		}
+		master.end_batch(*this, block->batch_idx, block->n_measure, progress_bar);
+		if (!free_ring.try_push(block))
+		{
+			delete block;
+		}
+	}
+}
+
+/* -L: n_producer threads simulate the batches of -J and push them as blocks
+   of traces into a bounded ring, n_consumer threads pop the blocks into their
+   own accumulators. A full ring holds the producers back, the consumed blocks
+   are recycled through a second ring. The results are those of -J */
+void Campaign::run_pipeline(void)
+{
+	std::vector<Campaign *> producers;
+	std::vector<Campaign *> consumers;
+	std::vector<std::thread> producer_threads;
+	std::vector<std::thread> consumer_threads;
+	std::atomic<unsigned long int> next_batch(0);
+	Trace_ring ring(2*this->options.n_consumer);
+	Trace_ring free_ring(2*this->options.n_consumer + this->options.n_producer + this->options.n_consumer);
+
+	this->options.n_warmup = 0;
+	for (unsigned int k = 0; k < this->options.n_producer; ++k)
+	{
+		producers.push_back(new Campaign(this->options, this->sec_algo));
+	}
+	for (unsigned int k = 0; k < this->options.n_consumer; ++k)
+	{
+		consumers.push_back(new Campaign(this->options, this->sec_algo));
+	}
+
+	Progress_bar progress_bar(this->options.n_measure, std::cout, "Simulating " + this->sec_algo.name + " with "
+		+ std::to_string(this->options.n_producer) + " producers and " + std::to_string(this->options.n_consumer) + " consumers ...\n");
+	for (auto consumer : consumers)
+	{
+		consumer_threads.push_back(std::thread(&Campaign::consume_blocks, consumer, std::ref(*this), std::ref(ring),
+			std::ref(free_ring), std::ref(progress_bar)));
+	}
+	for (auto producer : producers)
+	{
+		producer_threads.push_back(std::thread(&Campaign::produce_blocks, producer, std::ref(*this), std::ref(next_batch),
+			std::ref(ring), std::ref(free_ring)));
+	}
+	for (auto &thread : producer_threads)
+	{
+		thread.join();
+	}
+	for (unsigned int k = 0; k < this->options.n_consumer; ++k)
+	{
+		ring.push(nullptr);
+	}
+	for (auto &thread : consumer_threads)
+	{
+		thread.join();
+	}
+	for (Trace_block *block; free_ring.try_pop(block); )
+	{
+		delete block;
+	}
+
+	Cpu *trace_cpu_ptr = &this->cpu;
+	for (auto producer : producers)
+	{
+		trace_cpu_ptr = producer->trace.empty() ? trace_cpu_ptr : &producer->cpu;
+	}
+	this->save_worker_results(consumers, trace_cpu_ptr);
+	for (auto worker : producers)
+	{
+		delete worker;
+	}
+	for (auto worker : consumers)
+	{
+		delete worker;
+	}
+}
+
+void Campaign::run(void)
+{
+	unsigned long int first_measure = 0;
+
+	if (this->options.n_worker > 1)
+	{
+		this->run_workers();
+		return;
+	}
+	if (this->options.n_producer > 0)
+	{
+		this->run_pipeline();
+		return;
+	}
+	this->sec_algo.load(&this->cpu);
+	this->cpu.reset();
+	if (this->options.resume || this->options.n_extend > 0)
+	{
+		first_measure = this->load_checkpoint();
+	}
+	/* the CPA success curve uses the same points, 10 per decade by default */
+	unsigned int points_per_decade = (this->options.convergence_ppd > 0) ? this->options.convergence_ppd : 10;
+	unsigned long int next_point = next_convergence_point(first_measure, points_per_decade);
+
+	Progress_bar progress_bar(this->options.n_measure - first_measure, std::cout, "Simulating " + this->sec_algo.name + " ...\n");
+	for (unsigned long int measure_idx = first_measure; measure_idx < this->options.n_measure; ++measure_idx)
+	{
+		this->simulate(measure_idx);
+		if (measure_idx + 1 == this->options.n_warmup && !this->options.with_alignment)
+		{
+			this->end_warmup();
+		}
+		/* the first-order t-test only exists once the warm-up is over */
+		if (measure_idx + 1 == next_point)
+		{
+			next_point = next_convergence_point(next_point, points_per_decade);
+			if (this->cpa_ptr != nullptr)
+			{
+				this->track_cpa(measure_idx + 1);
+			}
+			if ((this->options.convergence_ppd > 0 || this->hotspot_ptr != nullptr)
+				&& (this->options.with_alignment || this->sample_filter_ptr->is_frozen()))
+			{
+				std::vector<std::vector<double>> t = this->t_tests();
+				if (this->hotspot_ptr != nullptr)
+				{
+					this->track_hotspots(measure_idx + 1, t);
+				}
+				if (this->options.convergence_ppd > 0 && this->track_convergence(measure_idx + 1, t))
+				{
+					this->stop(measure_idx + 1);
+				}
+			}
+		}
+		if (this->options.checkpoint_interval > 0 && (measure_idx + 1) % this->options.checkpoint_interval == 0
+			&& measure_idx + 1 < this->options.n_measure && this->sample_filter_ptr->is_frozen())
+		{
+			this->save_checkpoint(measure_idx + 1);
+		}
+		++progress_bar;
+	}
+
+	if (!this->options.with_alignment && !this->sample_filter_ptr->is_frozen())
+	{
+		this->end_warmup();
+	}
+	if (this->options.convergence_ppd > 0)
+	{
+		unsigned int n_col = this->get_n_convergence_col();
+		if (this->convergence.empty() || this->convergence[this->convergence.size() - n_col] != this->options.n_measure)
+		{
+			this->track_convergence(this->options.n_measure, this->t_tests());
+		}
+		save_npy(this->output_filename("convergence"), this->convergence, n_col);
+	}
+	if (this->options.checkpoint_interval > 0)
+	{
+		this->save_checkpoint(this->options.n_measure);
+	}
+	this->save_results();
+}
@@ -0,0 +1,202 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * t-test campaign (fixed vs random)
+ *
+ ******************************************************************************/
+
+#ifndef __CAMPAIGN_H__
+#define __CAMPAIGN_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <random>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include "cpu.h"
+#include "options.h"
+#include "t_test.h"
+#include "power_sum.h"
+#include "moment_ttest.h"
+#include "bivariate_ttest.h"
+#include "cpa.h"
+#include "bit_test.h"
+#include "histogram_test.h"
+#include "conditional_histogram.h"
+#include "template_builder.h"
+#include "hotspot.h"
+#include "anova.h"
+#include "sparse_result.h"
+#include "sample_pool.h"
+#include "trace_batch.h"
+#include "trace_ring.h"
+#include "sample_filter.h"
+#include "align.h"
+#include "npy.h"
+#include "scope.h"
+#include "state_file.h"
+#include "progress_bar.h"
+
+typedef enum
+{
+	INPUT_FIXED,
+	INPUT_RANDOM,
+	INPUT_FIXED_2                         /* second fixed input of the control test (-x): the complement of the fixed input */
+} Input_class;
+
+/* simulator specific part of a campaign */
+typedef struct
+{
+	std::string name;                     /* name of the implementation */
+	unsigned int n_input;                 /* number of 32-bit input words of a measure */
+	void (*load)(Cpu *cpu);               /* load the firmware */
+	void (*measure)(                      /* simulate one measure of the given class */
+		std::mt19937 &rnd_gen_uint32,     /* and write its inputs to inputs[0..n_input-1] */
+		Cpu *cpu,
+		Input_class input_class,
+		uint32_t *inputs
+	);
+	unsigned int n_guess;                 /* number of key guesses of the leakage model (CPA) */
+	unsigned int correct_guess;           /* guess matching the key of the implementation */
+	void (*model)(                        /* hypothetical leakage h[0..n_guess-1] of each guess (8-bit), */
+		const uint32_t *inputs,           /* nullptr if the implementation has no leakage model */
+		unsigned int *h
+	);
+	unsigned int n_value;                 /* number of values of the intermediate of the SNR and MI */
+	unsigned int (*intermediate)(         /* value of the intermediate (0..n_value-1), */
+		const uint32_t *inputs            /* nullptr if the implementation does not provide it */
+	);
+} Sec_algo;
+
+class Campaign
+{
+	private:
+		Options &options;
+		const Sec_algo &sec_algo;
+		Cpu cpu;
+		std::mt19937 rnd_gen_uint32;
+		Scope scope;
+		bool initialized;
+		std::vector<unsigned int> trace;
+		std::vector<unsigned int> compact_trace;
+		std::vector<std::vector<unsigned int>> warmup_traces[2];
+		Trace_batch ttest_batch[2];        /* compacted traces not yet in the t-tests, by class */
+		Trace_batch histogram_batch[2];    /* traces not yet in the histograms, by class */
+		std::vector<uint32_t> bit_trace;
+		std::vector<uint32_t> pc_trace;
+		std::vector<uint32_t> inputs;
+		std::vector<unsigned int> poi_trace;
+		Sample_filter *sample_filter_ptr;
+		Power_sum_ttest *ttest_ptr;
+		unsigned int n_trace_per_measure;  /* 3 with the control tests */
+		Power_sum_ttest *fvf_ttest_ptr;
+		Power_sum_ttest *rvr_ttest_ptr;
+		Moment_ttest *moment_ttest_ptr;
+		Bivariate_ttest *bivariate_ttest_ptr;
+		Cpa *cpa_ptr;
+		std::vector<unsigned int> hypotheses;
+		Bit_test *bit_test_ptr;
+		Histogram_test *histogram_test_ptr;
+		Conditional_histogram *conditional_histogram_ptr;
+		Template_builder *template_builder_ptr;
+		std::vector<unsigned int> template_trace;
+		Hotspot_report *hotspot_ptr;
+		Anova *anova_ptr;
+		Sample_pool *sample_pool_ptr;      /* nullptr with one thread */
+		Aligner *aligner_ptr;
+		Aligned_ttest *aligned_ttest_ptr;
+		Npy_matrix *trace_npy_ptr;
+		Npy_matrix *label_npy_ptr;
+		Npy_matrix *input_npy_ptr;
+		Npy_matrix *bit_trace_npy_ptr;
+		std::vector<double> convergence;   /* rows of (n, max |t| of each test) */
+		unsigned int n_over_threshold;
+		std::vector<double> cpa_curve;     /* rows of (n, rank, peak correlation of the correct guess and of the best other) */
+		Cpu *trace_cpu_ptr;                /* cpu of the last trace, giving the pc and source of the samples */
+		uint64_t batch_seed;               /* seed of the inputs of the batches of the workers (-J) */
+		std::mutex worker_mutex;
+		std::map<unsigned long int, Moment_ttest *> pending_moments; /* moments of the batches done ahead of the merge */
+		unsigned long int next_moment_batch;
+
+		std::string output_filename(std::string suffix, std::string extension = ".npy") const;
+		void acquire(unsigned long int measure_idx, Input_class input_class);
+		void init(void);
+		void accumulate(unsigned long int measure_idx, Input_class input_class);
+		void simulate(unsigned long int measure_idx);
+		void end_warmup(void);
+		void update_ttest(Input_class input_class, const std::vector<unsigned int> &vec);
+		void flush_ttest_batch(Input_class input_class);
+		void flush_histogram_batch(Input_class input_class);
+		void flush_batches(void);
+		void update_bivariate(Input_class input_class);
+		void update(Input_class input_class);
+		void update_control(unsigned long int measure_idx, Input_class input_class);
+		void save_control(void);
+		void save_bivariate(void);
+		void to_full_trace(void);
+		void write_settings(State_writer &writer) const;
+		void check_settings(State_reader &reader) const;
+		void save_accumulators(State_writer &writer);
+		void save_state(std::string filename);
+		void merge_state(std::string filename);
+		void save_checkpoint(unsigned long int n_done);
+		unsigned int get_n_convergence_col(void) const;
+		std::vector<std::vector<double>> t_tests(void);
+		std::vector<double> max_abs_t(const std::vector<std::vector<double>> &t) const;
+		bool track_convergence(unsigned long int n_done, const std::vector<std::vector<double>> &t);
+		void track_hotspots(unsigned long int n_done, const std::vector<std::vector<double>> &t);
+		void save_hotspots(void);
+		void save_sparse(std::string prefix, const std::vector<double> &t);
+		void stop(unsigned long int n_done);
+		void track_cpa(unsigned long int n_done);
+		void save_cpa(void);
+		void save_templates(void);
+		unsigned long int load_checkpoint(void);
+		void save_results(void);
+		void open_trace_files(unsigned long int n_sample);
+		void save_trace(unsigned long int row_idx, Input_class input_class);
+		unsigned long int get_n_batch(void) const;
+		void start_batch(Campaign &master, Cpu &initial_cpu, unsigned long int batch_idx);
+		void run_batches(Campaign &master, std::atomic<unsigned long int> &next_batch, Progress_bar &progress_bar);
+		void end_batch(Campaign &worker, unsigned long int batch_idx, unsigned long int n_done, Progress_bar &progress_bar);
+		void merge_worker(Campaign &worker);
+		void save_worker_results(const std::vector<Campaign *> &workers, Cpu *trace_cpu_ptr);
+		void run_workers(void);
+		void produce_blocks(Campaign &master, std::atomic<unsigned long int> &next_batch, Trace_ring &ring, Trace_ring &free_ring);
+		void consume_blocks(Campaign &master, Trace_ring &ring, Trace_ring &free_ring, Progress_bar &progress_bar);
+		void run_pipeline(void);
+
+	public:
+		Campaign(Options &options, const Sec_algo &sec_algo);
+		~Campaign();
+		void run(void);
+};
+
+#endif
@@ -0,0 +1,987 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Host-only check of the statistics accumulators against two-pass references
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <random>
+#include <string>
+#include <functional>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "power_sum.h"
+#include "moment_ttest.h"
+#include "cpa.h"
+#include "anova.h"
+#include "bit_test.h"
+#include "bivariate_ttest.h"
+#include "histogram_test.h"
+#include "conditional_histogram.h"
+#include "template_builder.h"
+#include "scope.h"
+#include "options.h"
+#include "sample_filter.h"
+#include "state_file.h"
+#include "sample_pool.h"
+#include "utils.h"
+
+#define N_SAMPLE 77
+#define N_ROW 1500                         /* distinct rows per class, each standing for 1 to 3 traces */
+#define MAX_ORDER 3
+#define N_GUESS 5
+#define N_CLASS 9
+#define WINDOW 4
+#define N_BIN 128
+#define POI_FIRST 5                        /* points of interest of the templates */
+#define N_POI 20
+#define MAX_DECIMATION 4
+#define ADC_OFFSET 64                      /* ADC code of a null Hamming weight, as in scope.cpp */
+#define ADC_MAX 255
+#define N_MASK_SAMPLE 5
+#define N_MASK 3000                        /* transition masks per class */
+#define TOLERANCE 1e-9
+#define STATE_FILENAME "check_accumulators.state"
+
+/* the traces of a class: rows of 8-bit samples, each with a weight */
+typedef struct
+{
+	std::vector<uint8_t> rows;
+	std::vector<unsigned int> weights;
+	std::vector<std::vector<unsigned int>> traces;   /* rows repeated weight times */
+} Class_data;
+
+static unsigned int n_failed = 0;
+
+/* Hamming weight like samples. Samples 10 to 19 leak the class in the mean,
+   20 to 29 in the variance, the last one is constant */
+static Class_data make_class(std::mt19937 &rnd_gen, unsigned int cls)
+{
+	Class_data data;
+
+	for (unsigned int r = 0; r < N_ROW; ++r)
+	{
+		std::vector<unsigned int> trace(N_SAMPLE);
+		for (unsigned int i = 0; i < N_SAMPLE; ++i)
+		{
+			unsigned int x = __builtin_popcount(rnd_gen());
+			if (i >= 10 && i < 20 && cls == 0)
+			{
+				x += rnd_gen() % 2;
+			}
+			else if (i >= 20 && i < 30 && cls == 0)
+			{
+				x = (rnd_gen() % 2) ? x/2 : 2*x;
+			}
+			trace[i] = (i == N_SAMPLE - 1) ? 7 : x;
+		}
+		unsigned int w = 1 + rnd_gen() % 3;
+		data.rows.insert(data.rows.end(), trace.begin(), trace.end());
+		data.weights.push_back(w);
+		for (unsigned int k = 0; k < w; ++k)
+		{
+			data.traces.push_back(trace);
+		}
+	}
+	return data;
+}
+
+static void check(std::string name, const std::vector<double> &value, const std::vector<double> &reference)
+{
+	double max_error = 0.0;
+
+	for (unsigned int i = 0; i < reference.size(); ++i)
+	{
+		double scale = (fabs(reference[i]) > 1.0) ? fabs(reference[i]) : 1.0;
+		double error = (i < value.size()) ? fabs(value[i] - reference[i])/scale : INFINITY;
+		max_error = (error > max_error || std::isnan(error)) ? error : max_error;
+	}
+	if (value.size() != reference.size() || !(max_error <= TOLERANCE))
+	{
+		printf("-- %s: relative error %g FAILED\n", name.c_str(), max_error);
+		n_failed++;
+	}
+	else
+	{
+		printf("-- %s: relative error %g ok\n", name.c_str(), max_error);
+	}
+}
+
+static void check_same(std::string name, const std::string &value, const std::string &reference)
+{
+	if (value != reference)
+	{
+		printf("-- %s: states differ FAILED\n", name.c_str());
+		n_failed++;
+	}
+	else
+	{
+		printf("-- %s: same state ok\n", name.c_str());
+	}
+}
+
+static std::string read_file(std::string filename)
+{
+	std::string content;
+	char buffer[4096];
+	size_t length;
+	FILE *file = fopen(filename.c_str(), "rb");
+
+	if (file == NULL)
+	{
+		fprintf(stderr, "-- ERROR: can not open %s\n", filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		content.append(buffer, length);
+	}
+	fclose(file);
+	return content;
+}
+
+/* the bytes written by save() */
+template <class T> static std::string saved_state(T &accumulator)
+{
+	State_writer writer(STATE_FILENAME);
+
+	accumulator.save(writer);
+	writer.close();
+	return read_file(STATE_FILENAME);
+}
+
+/* The state of an accumulator must be saved again unchanged once loaded in
+   an accumulator of another size. With merged != nullptr, the two halves
+   merged must give the state of the single pass, bit for bit */
+template <class T> static void check_state(std::string name, T &single, T *merged, T &fresh)
+{
+	std::string state = saved_state(single);
+	State_reader reader(STATE_FILENAME);
+
+	fresh.load(reader);
+	check_same(name + ", saved and loaded", saved_state(fresh), state);
+	if (merged != nullptr)
+	{
+		check_same(name + ", merged", saved_state(*merged), state);
+	}
+}
+
+/* task runs in a child process, and must exit with an error containing message */
+static void check_error(std::string name, const std::function<void(void)> &task, std::string message)
+{
+	std::string error;
+	char buffer[256];
+	ssize_t length;
+	int status;
+	int fd[2];
+
+	fflush(stdout);
+	if (pipe(fd) != 0)
+	{
+		fprintf(stderr, "-- ERROR: can not create a pipe\n");
+		std::exit(EXIT_FAILURE);
+	}
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		dup2(fd[1], STDERR_FILENO);
+		close(fd[0]);
+		task();
+		_exit(EXIT_SUCCESS);
+	}
+	close(fd[1]);
+	while ((length = read(fd[0], buffer, sizeof(buffer))) > 0)
+	{
+		error.append(buffer, length);
+	}
+	close(fd[0]);
+	waitpid(pid, &status, 0);
+	if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE && error.find(message) != std::string::npos)
+	{
+		printf("-- %s: rejected ok\n", name.c_str());
+	}
+	else
+	{
+		printf("-- %s: not rejected FAILED\n", name.c_str());
+		n_failed++;
+	}
+}
+
+/* Welch t-test at order d on the mean, the central moment of order 2 or the
+   standardized moment of order d, as documented in moment_ttest.h */
+static std::vector<double> reference_ttest(const Class_data data[2], unsigned int order)
+{
+	std::vector<double> t;
+
+	for (unsigned int i = 0; i < N_SAMPLE; ++i)
+	{
+		double m[2];
+		double v[2];
+		double n[2];
+		for (unsigned int cls = 0; cls < 2; ++cls)
+		{
+			const std::vector<std::vector<unsigned int>> &traces = data[cls].traces;
+			long double mean = 0.0L;
+			long double cm[2*MAX_ORDER + 1] = {0.0L};
+			n[cls] = traces.size();
+			for (auto &trace : traces)
+			{
+				mean += trace[i];
+			}
+			mean /= traces.size();
+			for (auto &trace : traces)
+			{
+				long double power = 1.0L;
+				for (unsigned int p = 1; p <= 2*order; ++p)
+				{
+					power *= trace[i] - mean;
+					cm[p] += power;
+				}
+			}
+			for (unsigned int p = 1; p <= 2*order; ++p)
+			{
+				cm[p] /= traces.size();
+			}
+			if (order == 1)
+			{
+				m[cls] = mean;
+				v[cls] = cm[2]*n[cls]/(n[cls] - 1);
+			}
+			else if (order == 2)
+			{
+				m[cls] = cm[2];
+				v[cls] = cm[4] - cm[2]*cm[2];
+			}
+			else
+			{
+				m[cls] = (cm[2] == 0.0L) ? 0.0 : cm[order]/powl(cm[2], 0.5L*order);
+				v[cls] = (cm[2] == 0.0L) ? 0.0 : (cm[2*order] - cm[order]*cm[order])/powl(cm[2], order);
+			}
+		}
+		double term = sqrt(v[0]/n[0] + v[1]/n[1]);
+		t.push_back((term == 0.0) ? 0.0 : (m[0] - m[1])/term);
+	}
+	return t;
+}
+
+static void check_power_sum(const Class_data data[2], Sample_pool &pool)
+{
+	std::vector<double> reference = reference_ttest(data, 1);
+	Power_sum_ttest single(N_SAMPLE);
+	Power_sum_ttest batch(N_SAMPLE);
+	Power_sum_ttest half_a(N_SAMPLE);
+	Power_sum_ttest half_b(N_SAMPLE);
+
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		for (unsigned int k = 0; k < data[cls].traces.size(); ++k)
+		{
+			const std::vector<unsigned int> &trace = data[cls].traces[k];
+			Power_sum_ttest &half = (k % 2 == 0) ? half_a : half_b;
+			if (cls == 0)
+			{
+				single.update1(trace);
+				half.update1(trace);
+			}
+			else
+			{
+				single.update2(trace);
+				half.update2(trace);
+			}
+		}
+	}
+	batch.update1_batch(data[0].rows.data(), N_ROW, data[0].weights.data(), &pool);
+	batch.update2_batch(data[1].rows.data(), N_ROW, data[1].weights.data());
+	half_a.merge(half_b);
+	check("power sums, trace by trace", single.t_test(), reference);
+	check("power sums, weighted batches", batch.t_test(), reference);
+	check("power sums, merged", half_a.t_test(), reference);
+	Power_sum_ttest fresh(1);
+	check_state("power sums", single, &half_a, fresh);
+	check_same("power sums, weighted batches", saved_state(batch), saved_state(single));
+}
+
+static void check_moments(const Class_data data[2], Sample_pool &pool)
+{
+	Moment_ttest single(N_SAMPLE, MAX_ORDER);
+	Moment_ttest batch(N_SAMPLE, MAX_ORDER);
+	Moment_ttest half_a(N_SAMPLE, MAX_ORDER);
+	Moment_ttest half_b(N_SAMPLE, MAX_ORDER);
+
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		for (unsigned int k = 0; k < data[cls].traces.size(); ++k)
+		{
+			const std::vector<unsigned int> &trace = data[cls].traces[k];
+			Moment_ttest &half = (k < data[cls].traces.size()/3) ? half_a : half_b;
+			if (cls == 0)
+			{
+				single.update1(trace);
+				half.update1(trace);
+			}
+			else
+			{
+				single.update2(trace);
+				half.update2(trace);
+			}
+		}
+	}
+	batch.update1_batch(data[0].rows.data(), N_ROW, data[0].weights.data(), &pool);
+	batch.update2_batch(data[1].rows.data(), N_ROW, data[1].weights.data());
+	half_a.merge(half_b);
+	for (unsigned int order = 1; order <= MAX_ORDER; ++order)
+	{
+		std::vector<double> reference = reference_ttest(data, order);
+		std::string suffix = " (order " + std::to_string(order) + ")";
+		check("moments, trace by trace" + suffix, single.t_test(order), reference);
+		check("moments, weighted batches" + suffix, batch.t_test(order), reference);
+		check("moments, merged" + suffix, half_a.t_test(order), reference);
+	}
+	/* central sums are merged in floating point, so only the loaded state is
+	   the same bit for bit */
+	Moment_ttest fresh(1, 1);
+	check_state<Moment_ttest>("moments", single, nullptr, fresh);
+}
+
+/* hypotheses of the random class: 8-bit values correlated with sample 10 */
+static void check_cpa(const Class_data &data, std::mt19937 &rnd_gen)
+{
+	std::vector<std::vector<unsigned int>> h;
+	Cpa cpa(N_SAMPLE, N_GUESS);
+	Cpa half_a(N_SAMPLE, N_GUESS);
+	Cpa half_b(N_SAMPLE, N_GUESS);
+	std::vector<double> reference;
+
+	for (unsigned int k = 0; k < data.traces.size(); ++k)
+	{
+		std::vector<unsigned int> hk(N_GUESS);
+		for (unsigned int g = 0; g < N_GUESS; ++g)
+		{
+			hk[g] = (g == 0) ? data.traces[k][10]*4 + rnd_gen() % 8 : rnd_gen() % 256;
+		}
+		h.push_back(hk);
+		cpa.update(data.traces[k], hk);
+		((k % 2 == 0) ? half_a : half_b).update(data.traces[k], hk);
+	}
+	for (unsigned int g = 0; g < N_GUESS; ++g)
+	{
+		for (unsigned int i = 0; i < N_SAMPLE; ++i)
+		{
+			long double n = data.traces.size();
+			long double mx = 0.0L;
+			long double mh = 0.0L;
+			long double sxx = 0.0L;
+			long double shh = 0.0L;
+			long double sxh = 0.0L;
+			for (unsigned int k = 0; k < data.traces.size(); ++k)
+			{
+				mx += data.traces[k][i];
+				mh += h[k][g];
+			}
+			mx /= n;
+			mh /= n;
+			for (unsigned int k = 0; k < data.traces.size(); ++k)
+			{
+				sxx += (data.traces[k][i] - mx)*(data.traces[k][i] - mx);
+				shh += (h[k][g] - mh)*(h[k][g] - mh);
+				sxh += (data.traces[k][i] - mx)*(h[k][g] - mh);
+			}
+			reference.push_back((sxx == 0.0L || shh == 0.0L) ? 0.0 : static_cast<double>(sxh/sqrtl(sxx*shh)));
+		}
+	}
+	half_a.merge(half_b);
+	check("CPA", cpa.correlation(), reference);
+	check("CPA, merged", half_a.correlation(), reference);
+	Cpa fresh(1, 1);
+	check_state("CPA", cpa, &half_a, fresh);
+}
+
+/* classes are the value of sample 10 modulo N_CLASS */
+static void check_anova(const Class_data &data)
+{
+	Anova anova(N_SAMPLE, N_CLASS);
+	Anova half_a(N_SAMPLE, N_CLASS);
+	Anova half_b(N_SAMPLE, N_CLASS);
+	std::vector<double> reference;
+
+	for (unsigned int k = 0; k < data.traces.size(); ++k)
+	{
+		anova.update(data.traces[k], data.traces[k][10] % N_CLASS);
+		((k % 2 == 0) ? half_a : half_b).update(data.traces[k], data.traces[k][10] % N_CLASS);
+	}
+	for (unsigned int i = 0; i < N_SAMPLE; ++i)
+	{
+		long double mean = 0.0L;
+		long double mean_c[N_CLASS] = {0.0L};
+		long double n_c[N_CLASS] = {0.0L};
+		long double ssb = 0.0L;
+		long double ssw = 0.0L;
+		unsigned int k_seen = 0;
+		for (auto &trace : data.traces)
+		{
+			mean += trace[i];
+			mean_c[trace[10] % N_CLASS] += trace[i];
+			n_c[trace[10] % N_CLASS]++;
+		}
+		mean /= data.traces.size();
+		for (unsigned int c = 0; c < N_CLASS; ++c)
+		{
+			if (n_c[c] > 0)
+			{
+				mean_c[c] /= n_c[c];
+				ssb += n_c[c]*(mean_c[c] - mean)*(mean_c[c] - mean);
+				k_seen++;
+			}
+		}
+		for (auto &trace : data.traces)
+		{
+			ssw += (trace[i] - mean_c[trace[10] % N_CLASS])*(trace[i] - mean_c[trace[10] % N_CLASS]);
+		}
+		if (ssw > 0.0L)
+		{
+			reference.push_back(static_cast<double>((ssb/(k_seen - 1))/(ssw/(data.traces.size() - k_seen))));
+		}
+		else
+		{
+			reference.push_back((ssb > 0.0L) ? INFINITY : 0.0);
+		}
+	}
+	half_a.merge(half_b);
+	check("ANOVA", anova.f_test(), reference);
+	check("ANOVA, merged", half_a.f_test(), reference);
+	Anova fresh(1, 1);
+	check_state("ANOVA", anova, &half_a, fresh);
+}
+
+/* Welch t-test on the centered products of the pairs (i, i + d), computed
+   from the products themselves */
+static void check_bivariate(const Class_data data[2])
+{
+	Bivariate_ttest bivariate(N_SAMPLE, WINDOW);
+	Bivariate_ttest half_a(N_SAMPLE, WINDOW);
+	Bivariate_ttest half_b(N_SAMPLE, WINDOW);
+	std::vector<double> reference(N_SAMPLE*WINDOW, 0.0);
+
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		for (unsigned int k = 0; k < data[cls].traces.size(); ++k)
+		{
+			const std::vector<unsigned int> &trace = data[cls].traces[k];
+			Bivariate_ttest &half = (k % 3 == 0) ? half_a : half_b;
+			if (cls == 0)
+			{
+				bivariate.update1(trace);
+				half.update1(trace);
+			}
+			else
+			{
+				bivariate.update2(trace);
+				half.update2(trace);
+			}
+		}
+	}
+	for (unsigned int i = 0; i < N_SAMPLE; ++i)
+	{
+		for (unsigned int d = 1; d <= WINDOW && i + d < N_SAMPLE; ++d)
+		{
+			long double m[2];
+			long double v[2];
+			long double n[2];
+			for (unsigned int cls = 0; cls < 2; ++cls)
+			{
+				const std::vector<std::vector<unsigned int>> &traces = data[cls].traces;
+				long double mean_i = 0.0L;
+				long double mean_j = 0.0L;
+				n[cls] = traces.size();
+				for (auto &trace : traces)
+				{
+					mean_i += trace[i];
+					mean_j += trace[i + d];
+				}
+				mean_i /= n[cls];
+				mean_j /= n[cls];
+				std::vector<long double> y;
+				m[cls] = 0.0L;
+				for (auto &trace : traces)
+				{
+					y.push_back((trace[i] - mean_i)*(trace[i + d] - mean_j));
+					m[cls] += y.back();
+				}
+				m[cls] /= n[cls];
+				v[cls] = 0.0L;
+				for (long double y_k : y)
+				{
+					v[cls] += (y_k - m[cls])*(y_k - m[cls]);
+				}
+				v[cls] /= n[cls];
+			}
+			long double term = sqrtl(v[0]/n[0] + v[1]/n[1]);
+			reference[i*WINDOW + d - 1] = (term == 0.0L) ? 0.0 : static_cast<double>((m[0] - m[1])/term);
+		}
+	}
+	half_a.merge(half_b);
+	check("bivariate t-test", bivariate.t_test(), reference);
+	check("bivariate t-test, merged", half_a.t_test(), reference);
+	Bivariate_ttest fresh(1, 1);
+	check_state("bivariate t-test", bivariate, &half_a, fresh);
+}
+
+/* -log10 of the upper tail of the chi-square distribution, from the closed
+   forms of Q(dof/2, x/2) for integer and half-integer dof/2 */
+static long double reference_chi2_log10_p(long double chi2, unsigned int dof)
+{
+	long double x = chi2/2;
+	long double q;
+
+	if (dof % 2 == 0)
+	{
+		/* e^-x sum_(j < dof/2) x^j/j! */
+		long double term = 1.0L;
+		long double sum = 1.0L;
+		for (unsigned int j = 1; j < dof/2; ++j)
+		{
+			term *= x/j;
+			sum += term;
+		}
+		q = expl(-x)*sum;
+	}
+	else
+	{
+		/* erfc(sqrt(x)) + e^-x sum_(1 <= j <= (dof - 1)/2) x^(j - 1/2)/gamma(j + 1/2) */
+		long double term = sqrtl(x)/tgammal(1.5L);
+		long double sum = 0.0L;
+		for (unsigned int j = 1; j <= (dof - 1)/2; ++j)
+		{
+			sum += term;
+			term *= x/(j + 0.5L);
+		}
+		q = erfcl(sqrtl(x)) + expl(-x)*sum;
+	}
+	return -log10l(q);
+}
+
+/* the 2 x N_BIN contingency table of each sample is counted from the traces */
+static void check_histogram(const Class_data data[2], Sample_pool &pool)
+{
+	Histogram_test histogram(N_SAMPLE, N_BIN);
+	Histogram_test batch(N_SAMPLE, N_BIN);
+	Histogram_test half_a(N_SAMPLE, N_BIN);
+	Histogram_test half_b(N_SAMPLE, N_BIN);
+	std::vector<double> reference;
+
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		for (unsigned int k = 0; k < data[cls].traces.size(); ++k)
+		{
+			const std::vector<unsigned int> &trace = data[cls].traces[k];
+			Histogram_test &half = (k % 2 == 0) ? half_a : half_b;
+			if (cls == 0)
+			{
+				histogram.update1(trace);
+				half.update1(trace);
+			}
+			else
+			{
+				histogram.update2(trace);
+				half.update2(trace);
+			}
+		}
+	}
+	batch.update1_batch(data[0].rows.data(), N_ROW, data[0].weights.data(), &pool);
+	batch.update2_batch(data[1].rows.data(), N_ROW, data[1].weights.data());
+	for (unsigned int i = 0; i < N_SAMPLE; ++i)
+	{
+		long double observed[2][N_BIN] = {{0.0L}};
+		long double n[2];
+		for (unsigned int cls = 0; cls < 2; ++cls)
+		{
+			n[cls] = data[cls].traces.size();
+			for (auto &trace : data[cls].traces)
+			{
+				observed[cls][trace[i]]++;
+			}
+		}
+		long double chi2 = 0.0L;
+		unsigned int n_nonempty = 0;
+		for (unsigned int v = 0; v < N_BIN; ++v)
+		{
+			long double column = observed[0][v] + observed[1][v];
+			if (column == 0.0L)
+			{
+				continue;
+			}
+			for (unsigned int cls = 0; cls < 2; ++cls)
+			{
+				long double expected = n[cls]*column/(n[0] + n[1]);
+				chi2 += (observed[cls][v] - expected)*(observed[cls][v] - expected)/expected;
+			}
+			n_nonempty++;
+		}
+		reference.push_back((n_nonempty < 2) ? 0.0 : static_cast<double>(reference_chi2_log10_p(chi2, n_nonempty - 1)));
+	}
+	half_a.merge(half_b);
+	check("histogram chi-square", histogram.chi2_test(), reference);
+	check("histogram chi-square, weighted batches", batch.chi2_test(), reference);
+	check("histogram chi-square, merged", half_a.chi2_test(), reference);
+	Histogram_test fresh(1, 1);
+	check_state("histograms", histogram, &half_a, fresh);
+	check_same("histograms, weighted batches", saved_state(batch), saved_state(histogram));
+}
+
+/* the intermediate value is sample 10 modulo N_CLASS. The SNR is computed
+   from the class means in two passes, the mutual information as
+   H(X) + H(V) - H(X, V) */
+static void check_conditional_histogram(const Class_data &data)
+{
+	Conditional_histogram histogram(N_SAMPLE, N_CLASS, N_BIN);
+	Conditional_histogram half_a(N_SAMPLE, N_CLASS, N_BIN);
+	Conditional_histogram half_b(N_SAMPLE, N_CLASS, N_BIN);
+	std::vector<double> reference_snr;
+	std::vector<double> reference_mi;
+
+	for (unsigned int k = 0; k < data.traces.size(); ++k)
+	{
+		histogram.update(data.traces[k], data.traces[k][10] % N_CLASS);
+		((k % 2 == 0) ? half_a : half_b).update(data.traces[k], data.traces[k][10] % N_CLASS);
+	}
+	for (unsigned int i = 0; i < N_SAMPLE; ++i)
+	{
+		long double n = data.traces.size();
+		long double mean = 0.0L;
+		long double mean_v[N_CLASS] = {0.0L};
+		long double n_v[N_CLASS] = {0.0L};
+		long double n_x[N_BIN] = {0.0L};
+		std::vector<long double> n_vx(N_CLASS*N_BIN, 0.0L);
+		long double signal = 0.0L;
+		long double noise = 0.0L;
+		for (auto &trace : data.traces)
+		{
+			unsigned int v = trace[10] % N_CLASS;
+			mean += trace[i];
+			mean_v[v] += trace[i];
+			n_v[v]++;
+			n_x[trace[i]]++;
+			n_vx[v*N_BIN + trace[i]]++;
+		}
+		mean /= n;
+		for (unsigned int v = 0; v < N_CLASS; ++v)
+		{
+			mean_v[v] = (n_v[v] > 0.0L) ? mean_v[v]/n_v[v] : 0.0L;
+			signal += n_v[v]*(mean_v[v] - mean)*(mean_v[v] - mean);
+		}
+		for (auto &trace : data.traces)
+		{
+			noise += (trace[i] - mean_v[trace[10] % N_CLASS])*(trace[i] - mean_v[trace[10] % N_CLASS]);
+		}
+		reference_snr.push_back((noise > 0.0L) ? static_cast<double>(signal/noise) : 0.0);
+		long double entropy = 0.0L;
+		for (unsigned int x = 0; x < N_BIN; ++x)
+		{
+			entropy -= (n_x[x] > 0.0L) ? n_x[x]/n*log2l(n_x[x]/n) : 0.0L;
+		}
+		for (unsigned int v = 0; v < N_CLASS; ++v)
+		{
+			entropy -= (n_v[v] > 0.0L) ? n_v[v]/n*log2l(n_v[v]/n) : 0.0L;
+		}
+		for (long double count : n_vx)
+		{
+			entropy += (count > 0.0L) ? count/n*log2l(count/n) : 0.0L;
+		}
+		reference_mi.push_back(entropy);
+	}
+	half_a.merge(half_b);
+	check("SNR", histogram.snr(), reference_snr);
+	check("mutual information", histogram.mutual_information(), reference_mi);
+	check("SNR, merged", half_a.snr(), reference_snr);
+	check("mutual information, merged", half_a.mutual_information(), reference_mi);
+	Conditional_histogram fresh(1, 1, 1);
+	check_state("conditional histograms", histogram, &half_a, fresh);
+}
+
+/* templates of the value of sample 10 modulo N_CLASS: class means and the
+   covariance of x - (mean of its class), pooled over the classes */
+static void check_templates(const Class_data &data)
+{
+	Template_builder templates(N_POI, N_CLASS);
+	Template_builder half_a(N_POI, N_CLASS);
+	Template_builder half_b(N_POI, N_CLASS);
+	std::vector<double> reference_mean(N_CLASS*N_POI, 0.0);
+	std::vector<double> reference_cov(N_POI*N_POI, 0.0);
+	long double mean[N_CLASS][N_POI] = {{0.0L}};
+	long double n_c[N_CLASS] = {0.0L};
+	unsigned int n_seen = 0;
+
+	for (unsigned int k = 0; k < data.traces.size(); ++k)
+	{
+		const std::vector<unsigned int> &trace = data.traces[k];
+		std::vector<unsigned int> poi(trace.begin() + POI_FIRST, trace.begin() + POI_FIRST + N_POI);
+		templates.update(poi, trace[10] % N_CLASS);
+		((k % 3 == 0) ? half_a : half_b).update(poi, trace[10] % N_CLASS);
+	}
+	for (auto &trace : data.traces)
+	{
+		n_c[trace[10] % N_CLASS]++;
+		for (unsigned int a = 0; a < N_POI; ++a)
+		{
+			mean[trace[10] % N_CLASS][a] += trace[POI_FIRST + a];
+		}
+	}
+	for (unsigned int c = 0; c < N_CLASS; ++c)
+	{
+		n_seen += (n_c[c] > 0.0L);
+		for (unsigned int a = 0; a < N_POI && n_c[c] > 0.0L; ++a)
+		{
+			mean[c][a] /= n_c[c];
+			reference_mean[c*N_POI + a] = mean[c][a];
+		}
+	}
+	for (unsigned int a = 0; a < N_POI; ++a)
+	{
+		for (unsigned int b = 0; b < N_POI; ++b)
+		{
+			long double scatter = 0.0L;
+			for (auto &trace : data.traces)
+			{
+				const long double *m = mean[trace[10] % N_CLASS];
+				scatter += (trace[POI_FIRST + a] - m[a])*(trace[POI_FIRST + b] - m[b]);
+			}
+			reference_cov[a*N_POI + b] = scatter/(data.traces.size() - n_seen);
+		}
+	}
+	half_a.merge(half_b);
+	check("template means", templates.means(), reference_mean);
+	check("template pooled covariance", templates.pooled_covariance(), reference_cov);
+	check("template means, merged", half_a.means(), reference_mean);
+	check("template pooled covariance, merged", half_a.pooled_covariance(), reference_cov);
+	Template_builder fresh(1, 1);
+	check_state("templates", templates, &half_a, fresh);
+}
+
+/* Filter and decimation against the direct form of the causal filter. The
+   taps and the gain are powers of 2, so both sides are exact and must give
+   the same ADC codes, the large samples being clipped. The noise of a trace
+   number must not depend on the traces processed before it */
+static void check_scope(const Class_data &data)
+{
+	Options options = default_options;
+	std::vector<unsigned int> trace(N_SAMPLE);
+
+	for (unsigned int i = 0; i < N_SAMPLE; ++i)
+	{
+		trace[i] = 3*data.traces[0][i];
+	}
+
+	options.fir_taps = {0.5, 0.25, 0.125, 0.0625, 0.0625};
+	options.adc_gain = 4.0;
+	for (unsigned int decimation = 1; decimation <= MAX_DECIMATION; ++decimation)
+	{
+		std::vector<unsigned int> out = trace;
+		std::vector<double> reference;
+		options.decimation = decimation;
+		Scope scope(options);
+		scope.apply(out, 0);
+		for (unsigned int pos = 0; pos < N_SAMPLE; pos += decimation)
+		{
+			long double y = 0.0L;
+			for (unsigned int k = 0; k < options.fir_taps.size() && k <= pos; ++k)
+			{
+				y += options.fir_taps[k]*trace[pos - k];
+			}
+			long int code = lroundl(options.adc_gain*y) + ADC_OFFSET;
+			reference.push_back((code < 0) ? 0 : (code > ADC_MAX) ? ADC_MAX : code);
+		}
+		check("scope filter, decimation " + std::to_string(decimation), std::vector<double>(out.begin(), out.end()), reference);
+	}
+
+	options.noise_sigma = 1.5;
+	Scope scope(options);
+	std::vector<unsigned int> first = trace;
+	std::vector<unsigned int> other = data.traces[1];
+	std::vector<unsigned int> again = trace;
+	scope.set_seed(12345);
+	scope.apply(first, 7);
+	scope.apply(other, 8);
+	scope.apply(again, 7);
+	check("scope noise, same trace number", std::vector<double>(again.begin(), again.end()),
+		std::vector<double>(first.begin(), first.end()));
+}
+
+/* the sample filter round trip, and the errors on a state of another class,
+   of another format version or truncated */
+static void check_state_errors(const Class_data &data)
+{
+	Sample_filter filter(N_SAMPLE);
+	Sample_filter fresh(1);
+	Anova anova(N_SAMPLE, N_CLASS);
+
+	for (auto &trace : data.traces)
+	{
+		filter.learn(trace);
+	}
+	filter.freeze();
+	check_state<Sample_filter>("sample filter", filter, nullptr, fresh);
+
+	std::string state = saved_state(anova);
+	check_error("state of another class", [] {
+		State_reader reader(STATE_FILENAME);
+		Histogram_test histogram(1, 1);
+		histogram.load(reader);
+	}, "found Anova state, expected Histogram_test");
+	check_error("state of another version", [&state] {
+		std::string other = state;
+		other[8]++;
+		FILE *file = fopen(STATE_FILENAME, "wb");
+		fwrite(other.data(), 1, other.size(), file);
+		fclose(file);
+		State_reader reader(STATE_FILENAME);
+	}, "has version");
+	check_error("truncated state", [&state] {
+		FILE *file = fopen(STATE_FILENAME, "wb");
+		fwrite(state.data(), 1, state.size() - 1, file);
+		fclose(file);
+		State_reader reader(STATE_FILENAME);
+		Anova anova(1, 1);
+		anova.load(reader);
+	}, "is truncated");
+	unlink(STATE_FILENAME);
+}
+
+/* 32-bit transition masks: sample 1 leaks the class, the low half of
+   sample 2 and the high byte of sample 3 are constant */
+static void check_bit_test(std::mt19937 &rnd_gen)
+{
+	std::vector<std::vector<uint32_t>> masks[2];
+	Bit_test bit_test(N_MASK_SAMPLE);
+	Bit_test half_a(N_MASK_SAMPLE);
+	Bit_test half_b(N_MASK_SAMPLE);
+	std::vector<double> reference_t;
+	std::vector<double> reference_chi2;
+
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		for (unsigned int k = 0; k < N_MASK; ++k)
+		{
+			std::vector<uint32_t> mask(N_MASK_SAMPLE);
+			for (unsigned int i = 0; i < N_MASK_SAMPLE; ++i)
+			{
+				mask[i] = rnd_gen();
+			}
+			mask[1] |= (cls == 0 && rnd_gen() % 5 == 0) ? 0xff : 0;
+			mask[2] &= 0xffff0000;
+			mask[3] |= 0xff000000;
+			masks[cls].push_back(mask);
+			Bit_test &half = (k % 2 == 0) ? half_a : half_b;
+			if (cls == 0)
+			{
+				bit_test.update1(mask);
+				half.update1(mask);
+			}
+			else
+			{
+				bit_test.update2(mask);
+				half.update2(mask);
+			}
+		}
+	}
+	for (unsigned int i = 0; i < N_MASK_SAMPLE; ++i)
+	{
+		for (unsigned int j = 0; j < 32; ++j)
+		{
+			long double p[2];
+			long double v[2];
+			long double ones[2];
+			for (unsigned int cls = 0; cls < 2; ++cls)
+			{
+				ones[cls] = 0.0L;
+				for (auto &mask : masks[cls])
+				{
+					ones[cls] += GET_BIT(mask[i], j);
+				}
+				p[cls] = ones[cls]/N_MASK;
+				v[cls] = 0.0L;
+				for (auto &mask : masks[cls])
+				{
+					v[cls] += (GET_BIT(mask[i], j) - p[cls])*(GET_BIT(mask[i], j) - p[cls]);
+				}
+				v[cls] /= N_MASK - 1;
+			}
+			long double term = sqrtl(v[0]/N_MASK + v[1]/N_MASK);
+			reference_t.push_back((term == 0.0L) ? 0.0 : static_cast<double>((p[0] - p[1])/term));
+			/* sum of (observed - expected)^2/expected over the (class, bit) table */
+			long double observed[2][2] = {{N_MASK - ones[0], ones[0]}, {N_MASK - ones[1], ones[1]}};
+			long double chi2 = 0.0L;
+			for (unsigned int b = 0; b < 2; ++b)
+			{
+				long double expected = (observed[0][b] + observed[1][b])/2;
+				for (unsigned int cls = 0; cls < 2 && expected > 0.0L; ++cls)
+				{
+					chi2 += (observed[cls][b] - expected)*(observed[cls][b] - expected)/expected;
+				}
+			}
+			bool is_constant = (ones[0] + ones[1] == 0.0L || ones[0] + ones[1] == 2*N_MASK);
+			reference_chi2.push_back(is_constant ? 0.0 : static_cast<double>(chi2));
+		}
+	}
+	half_a.merge(half_b);
+	check("bit t-test", bit_test.t_test(), reference_t);
+	check("bit chi-square", bit_test.chi2_test(), reference_chi2);
+	check("bit t-test, merged", half_a.t_test(), reference_t);
+	Bit_test fresh(1);
+	check_state("bit test", bit_test, &half_a, fresh);
+}
+
+int main(void)
+{
+	std::mt19937 rnd_gen(20170101);
+	Sample_pool pool(3);
+	Class_data data[2] = {make_class(rnd_gen, 0), make_class(rnd_gen, 1)};
+
+	check_power_sum(data, pool);
+	check_moments(data, pool);
+	check_cpa(data[1], rnd_gen);
+	check_anova(data[1]);
+	check_bivariate(data);
+	check_histogram(data, pool);
+	check_conditional_histogram(data[1]);
+	check_templates(data[1]);
+	check_scope(data[1]);
+	check_bit_test(rnd_gen);
+	check_state_errors(data[1]);
+	if (n_failed > 0)
+	{
+		fprintf(stderr, "-- ERROR: %u checks failed\n", n_failed);
+		return EXIT_FAILURE;
+	}
+	printf("-- all checks passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,251 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * SNR and mutual information from conditional histograms
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include "conditional_histogram.h"
+
+#define MAX_PENDING UINT32_MAX
+
+
+Conditional_histogram::Conditional_histogram(unsigned int n_sample, unsigned int n_value, unsigned int n_bin)
+{
+	this->n_sample = n_sample;
+	this->n_value = n_value;
+	this->n_bin = n_bin;
+	this->reset();
+}
+
+Conditional_histogram::~Conditional_histogram()
+{
+}
+
+void Conditional_histogram::reset(void)
+{
+	this->n = 0;
+	this->n_pending = 0;
+	this->counts.assign(static_cast<unsigned long int>(this->n_value)*this->n_bin*this->n_sample, 0);
+	this->totals.clear();
+}
+
+void Conditional_histogram::flush(void)
+{
+	if (this->totals.empty())
+	{
+		this->totals.assign(this->counts.size(), 0);
+	}
+	for (unsigned long int k = 0; k < this->counts.size(); ++k)
+	{
+		this->totals[k] += this->counts[k];
+	}
+	this->counts.assign(this->counts.size(), 0);
+	this->n_pending = 0;
+}
+
+void Conditional_histogram::update(const std::vector<unsigned int> &vec, unsigned int value)
+{
+	if (value >= this->n_value)
+	{
+		fprintf(stderr, "-- ERROR: intermediate value %u out of [0, %u)\n", value, this->n_value);
+		std::exit(EXIT_FAILURE);
+	}
+
+	uint32_t *h = this->counts.data() + static_cast<unsigned long int>(value)*this->n_bin;
+	unsigned long int stride = static_cast<unsigned long int>(this->n_value)*this->n_bin;
+
+	for (unsigned int i = 0; i < this->n_sample; ++i, h += stride)
+	{
+		if (vec[i] >= this->n_bin)
+		{
+			fprintf(stderr, "-- ERROR: sample value %u does not fit in %u histogram bins\n", vec[i], this->n_bin);
+			std::exit(EXIT_FAILURE);
+		}
+		h[vec[i]]++;
+	}
+	this->n++;
+	if (++this->n_pending == MAX_PENDING)
+	{
+		this->flush();
+	}
+}
+
+void Conditional_histogram::merge(const Conditional_histogram &other)
+{
+	if (other.n_sample != this->n_sample || other.n_value != this->n_value || other.n_bin != this->n_bin)
+	{
+		fprintf(stderr, "-- ERROR: can not merge conditional histograms of different sizes\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (this->totals.empty())
+	{
+		this->totals.assign(this->counts.size(), 0);
+	}
+	for (unsigned long int k = 0; k < this->totals.size(); ++k)
+	{
+		this->totals[k] += other.counts[k] + (other.totals.empty() ? 0 : other.totals[k]);
+	}
+	this->n += other.n;
+}
+
+void Conditional_histogram::save(State_writer &writer)
+{
+	this->flush();
+	writer.write_tag("Conditional_histogram");
+	writer.write_u64(this->n_sample);
+	writer.write_u64(this->n_value);
+	writer.write_u64(this->n_bin);
+	writer.write_u64(this->n);
+	writer.write(this->totals);
+}
+
+void Conditional_histogram::load(State_reader &reader)
+{
+	reader.read_tag("Conditional_histogram");
+	this->n_sample = reader.read_u64();
+	this->n_value = reader.read_u64();
+	this->n_bin = reader.read_u64();
+	this->reset();
+	this->n = reader.read_u64();
+	reader.read(this->totals);
+	if (this->totals.size() != this->counts.size())
+	{
+		fprintf(stderr, "-- ERROR: %s: inconsistent conditional histograms\n", reader.get_filename().c_str());
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+/* (n_value x n_bin) joint histogram of sample i, the pending counts included */
+const uint64_t *Conditional_histogram::histogram(unsigned int i, std::vector<uint64_t> &buffer) const
+{
+	unsigned long int stride = static_cast<unsigned long int>(this->n_value)*this->n_bin;
+	unsigned long int offset = stride*i;
+
+	buffer.resize(stride);
+	for (unsigned long int k = 0; k < stride; ++k)
+	{
+		buffer[k] = this->counts[offset + k] + (this->totals.empty() ? 0 : this->totals[offset + k]);
+	}
+	return buffer.data();
+}
+
+/* Var(E[X | V])/E[Var(X | V)] over the observed values of V. Infinite when
+   the sample is a deterministic, non-constant function of V (no noise) */
+std::vector<double> Conditional_histogram::snr(void) const
+{
+	std::vector<double> snr(this->n_sample, 0.0);
+	std::vector<uint64_t> buffer;
+
+	for (unsigned int i = 0; i < this->n_sample && this->n > 0; ++i)
+	{
+		const uint64_t *h = this->histogram(i, buffer);
+		double mean = 0.0;
+		double signal = 0.0;
+		double noise = 0.0;
+		std::vector<double> n_v(this->n_value, 0.0);
+		std::vector<double> mean_v(this->n_value, 0.0);
+
+		for (unsigned int v = 0; v < this->n_value; ++v, h += this->n_bin)
+		{
+			double s1 = 0.0;
+			double s2 = 0.0;
+			for (unsigned int x = 0; x < this->n_bin; ++x)
+			{
+				n_v[v] += h[x];
+				s1 += static_cast<double>(h[x])*x;
+				s2 += static_cast<double>(h[x])*x*x;
+			}
+			if (n_v[v] > 0.0)
+			{
+				mean_v[v] = s1/n_v[v];
+				noise += s2 - s1*mean_v[v];
+				mean += s1;
+			}
+		}
+		mean /= this->n;
+		for (unsigned int v = 0; v < this->n_value; ++v)
+		{
+			signal += n_v[v]*(mean_v[v] - mean)*(mean_v[v] - mean);
+		}
+		if (noise > 0.0)
+		{
+			snr[i] = signal/noise;
+		}
+		else if (signal > 0.0)
+		{
+			snr[i] = INFINITY;
+		}
+	}
+	return snr;
+}
+
+/* plug-in estimate, in bits, of I(X; V) = sum p(v, x) log2(p(v, x)/(p(v) p(x))).
+   It is biased upwards by about (n_value - 1)(n_bin - 1)/(2 n ln 2) for
+   independent variables, which matters with few traces */
+std::vector<double> Conditional_histogram::mutual_information(void) const
+{
+	std::vector<double> mi(this->n_sample, 0.0);
+	std::vector<uint64_t> buffer;
+	double n_total = this->n;
+
+	for (unsigned int i = 0; i < this->n_sample && this->n > 0; ++i)
+	{
+		const uint64_t *h = this->histogram(i, buffer);
+		std::vector<double> n_v(this->n_value, 0.0);
+		std::vector<double> n_x(this->n_bin, 0.0);
+		double sum = 0.0;
+
+		for (unsigned int v = 0; v < this->n_value; ++v)
+		{
+			for (unsigned int x = 0; x < this->n_bin; ++x)
+			{
+				n_v[v] += h[v*this->n_bin + x];
+				n_x[x] += h[v*this->n_bin + x];
+			}
+		}
+		for (unsigned int v = 0; v < this->n_value; ++v)
+		{
+			for (unsigned int x = 0; x < this->n_bin; ++x)
+			{
+				double n_vx = h[v*this->n_bin + x];
+				if (n_vx > 0.0)
+				{
+					sum += n_vx*log2(n_vx*n_total/(n_v[v]*n_x[x]));
+				}
+			}
+		}
+		mi[i] = sum/n_total;
+	}
+	return mi;
+}
@@ -0,0 +1,71 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * SNR and mutual information from conditional histograms
+ *
+ ******************************************************************************/
+
+#ifndef __CONDITIONAL_HISTOGRAM_H__
+#define __CONDITIONAL_HISTOGRAM_H__
+
+#include <cstdint>
+#include <vector>
+#include "state_file.h"
+
+/* Histogram of each sample conditioned on the value of an intermediate
+   variable (n_value values), i.e. the exact joint distribution of (value,
+   sample) per sample. The SNR and the mutual information are computed from
+   it. Counters are 32-bit, flushed to 64-bit counters (only allocated then)
+   before they can overflow */
+class Conditional_histogram
+{
+	private:
+		unsigned int n_sample;
+		unsigned int n_value;
+		unsigned int n_bin;
+		unsigned long int n;
+		unsigned long int n_pending;
+		std::vector<uint32_t> counts;      /* at (i*n_value + value)*n_bin + sample value */
+		std::vector<uint64_t> totals;      /* empty until the first flush */
+
+		void flush(void);
+		const uint64_t *histogram(unsigned int i, std::vector<uint64_t> &buffer) const;
+
+	public:
+		Conditional_histogram(unsigned int n_sample, unsigned int n_value, unsigned int n_bin);
+		~Conditional_histogram();
+		void reset(void);
+		void update(const std::vector<unsigned int> &vec, unsigned int value);
+		void merge(const Conditional_histogram &other);
+		void save(State_writer &writer);
+		void load(State_reader &reader);
+		std::vector<double> snr(void) const;
+		std::vector<double> mutual_information(void) const;
+};
+
+#endif
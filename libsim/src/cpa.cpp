@@ -0,0 +1,292 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Correlation power analysis
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include "cpa.h"
+#include "utils.h"
+
+/* traces buffered before the cross-products are updated */
+#define BATCH_SIZE 64
+/* 65535*255^2 < 2^32 */
+#define MAX_PENDING 65535
+/* tile of the cross-products kept in L1 while a batch is added */
+#define TILE_GUESS 16
+#define TILE_SAMPLE 512
+
+
+/* sxh[g][i] += sum_b h[b][g] x[b][i] for a tile of guesses and samples */
+AVX2_CLONES
+static void add_products(uint32_t *sxh, const uint32_t *x, const uint32_t *h, unsigned int n_batch,
+	unsigned int n_sample, unsigned int n_guess, unsigned int g0, unsigned int g1, unsigned int i0, unsigned int i1)
+{
+	for (unsigned int b = 0; b < n_batch; ++b)
+	{
+		const uint32_t *xb = x + b*n_sample;
+		for (unsigned int g = g0; g < g1; ++g)
+		{
+			const uint32_t hg = h[b*n_guess + g];
+			uint32_t *row = sxh + static_cast<unsigned long int>(g)*n_sample;
+			for (unsigned int i = i0; i < i1; ++i)
+			{
+				row[i] += hg*xb[i];
+			}
+		}
+	}
+}
+
+
+Cpa::Cpa(unsigned int n_sample, unsigned int n_guess)
+{
+	this->n_sample = n_sample;
+	this->n_guess = n_guess;
+	this->reset();
+}
+
+Cpa::~Cpa()
+{
+}
+
+void Cpa::reset(void)
+{
+	unsigned long int n_product = static_cast<unsigned long int>(this->n_guess)*this->n_sample;
+
+	this->n = 0;
+	this->n_pending = 0;
+	this->n_batch = 0;
+	this->sx.assign(this->n_sample, 0);
+	this->sx2.assign(this->n_sample, 0);
+	this->sh.assign(this->n_guess, 0);
+	this->sh2.assign(this->n_guess, 0);
+	this->sxh.assign(n_product, 0);
+	this->sxh_32.assign(n_product, 0);
+	this->batch_x.assign(BATCH_SIZE*this->n_sample, 0);
+	this->batch_h.assign(BATCH_SIZE*this->n_guess, 0);
+}
+
+unsigned int Cpa::get_n_sample(void) const
+{
+	return this->n_sample;
+}
+
+unsigned int Cpa::get_n_guess(void) const
+{
+	return this->n_guess;
+}
+
+/* h[g] is the hypothetical leakage of guess g for the inputs of the trace */
+void Cpa::update(const std::vector<unsigned int> &trace, const std::vector<unsigned int> &h)
+{
+	uint32_t *x = this->batch_x.data() + this->n_batch*this->n_sample;
+	uint32_t *hb = this->batch_h.data() + this->n_batch*this->n_guess;
+
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		x[i] = trace[i];
+		this->sx[i] += x[i];
+		this->sx2[i] += x[i]*x[i];
+	}
+	for (unsigned int g = 0; g < this->n_guess; ++g)
+	{
+		if (h[g] > 255)
+		{
+			fprintf(stderr, "-- ERROR: leakage model returned %u for guess %u, hypotheses must fit in 8 bits\n", h[g], g);
+			std::exit(EXIT_FAILURE);
+		}
+		hb[g] = h[g];
+		this->sh[g] += hb[g];
+		this->sh2[g] += hb[g]*hb[g];
+	}
+	this->n++;
+	if (++this->n_batch == BATCH_SIZE)
+	{
+		this->flush_batch();
+	}
+}
+
+void Cpa::flush_batch(void)
+{
+	if (this->n_batch == 0)
+	{
+		return;
+	}
+	if (this->n_pending + this->n_batch > MAX_PENDING)
+	{
+		this->flush();
+	}
+	for (unsigned int g0 = 0; g0 < this->n_guess; g0 += TILE_GUESS)
+	{
+		unsigned int g1 = (g0 + TILE_GUESS < this->n_guess) ? g0 + TILE_GUESS : this->n_guess;
+		for (unsigned int i0 = 0; i0 < this->n_sample; i0 += TILE_SAMPLE)
+		{
+			unsigned int i1 = (i0 + TILE_SAMPLE < this->n_sample) ? i0 + TILE_SAMPLE : this->n_sample;
+			add_products(this->sxh_32.data(), this->batch_x.data(), this->batch_h.data(), this->n_batch,
+				this->n_sample, this->n_guess, g0, g1, i0, i1);
+		}
+	}
+	this->n_pending += this->n_batch;
+	this->n_batch = 0;
+}
+
+void Cpa::flush(void)
+{
+	for (unsigned long int k = 0; k < this->sxh.size(); ++k)
+	{
+		this->sxh[k] += this->sxh_32[k];
+		this->sxh_32[k] = 0;
+	}
+	this->n_pending = 0;
+}
+
+/* n_guess x n_sample matrix of the correlations, 0 where a variance is 0 */
+std::vector<double> Cpa::correlation(void)
+{
+	std::vector<double> rho(this->sxh.size(), 0.0);
+
+	this->flush_batch();
+	this->flush();
+	for (unsigned int g = 0; g < this->n_guess; ++g)
+	{
+		__int128 var_h = static_cast<__int128>(this->n)*this->sh2[g] - static_cast<__int128>(this->sh[g])*this->sh[g];
+		for (unsigned int i = 0; i < this->n_sample; ++i)
+		{
+			__int128 var_x = static_cast<__int128>(this->n)*this->sx2[i] - static_cast<__int128>(this->sx[i])*this->sx[i];
+			__int128 cov = static_cast<__int128>(this->n)*this->sxh[static_cast<unsigned long int>(g)*this->n_sample + i]
+				- static_cast<__int128>(this->sx[i])*this->sh[g];
+			if (var_h > 0 && var_x > 0)
+			{
+				rho[static_cast<unsigned long int>(g)*this->n_sample + i] = static_cast<long double>(cov)/sqrtl(static_cast<long double>(var_h)*static_cast<long double>(var_x));
+			}
+		}
+	}
+	return rho;
+}
+
+/* Number of guesses whose highest correlation over the samples is above the
+   one of the given guess (0: the guess is the best). The signed correlation is
+   used since the simulated leakage grows with the Hamming weight: with a
+   model such as HW(v ^ guess), the complement of the guess gives the opposite
+   correlation and would tie with the absolute value */
+unsigned int Cpa::rank(const std::vector<double> &correlation, unsigned int guess) const
+{
+	std::vector<double> peak(this->n_guess, -1.0);
+	unsigned int rank = 0;
+
+	for (unsigned int g = 0; g < this->n_guess; ++g)
+	{
+		for (unsigned int i = 0; i < this->n_sample; ++i)
+		{
+			double rho = correlation[static_cast<unsigned long int>(g)*this->n_sample + i];
+			peak[g] = (rho > peak[g]) ? rho : peak[g];
+		}
+	}
+	for (unsigned int g = 0; g < this->n_guess; ++g)
+	{
+		if (peak[g] > peak[guess])
+		{
+			rank++;
+		}
+	}
+	return rank;
+}
+
+/* the batch and the 32-bit sums of the other analysis are added here */
+void Cpa::merge(const Cpa &other)
+{
+	if (other.n_sample != this->n_sample || other.n_guess != this->n_guess)
+	{
+		fprintf(stderr, "-- ERROR: can not merge CPA of %u samples x %u guesses and %u samples x %u guesses\n",
+			this->n_sample, this->n_guess, other.n_sample, other.n_guess);
+		std::exit(EXIT_FAILURE);
+	}
+	this->flush_batch();
+	this->flush();
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		this->sx[i] += other.sx[i];
+		this->sx2[i] += other.sx2[i];
+	}
+	for (unsigned int g = 0; g < this->n_guess; ++g)
+	{
+		this->sh[g] += other.sh[g];
+		this->sh2[g] += other.sh2[g];
+	}
+	for (unsigned long int k = 0; k < this->sxh.size(); ++k)
+	{
+		this->sxh[k] += other.sxh[k] + other.sxh_32[k];
+	}
+	/* the pending batch of other is only in its buffers */
+	this->batch_x.assign(other.batch_x.begin(), other.batch_x.end());
+	this->batch_h.assign(other.batch_h.begin(), other.batch_h.end());
+	this->n_batch = other.n_batch;
+	this->flush_batch();
+	this->n += other.n;
+}
+
+void Cpa::save(State_writer &writer)
+{
+	this->flush_batch();
+	this->flush();
+	writer.write_tag("Cpa");
+	writer.write_u64(this->n_sample);
+	writer.write_u64(this->n_guess);
+	writer.write_u64(this->n);
+	writer.write(this->sx);
+	writer.write(this->sx2);
+	writer.write(this->sh);
+	writer.write(this->sh2);
+	writer.write(this->sxh);
+}
+
+void Cpa::load(State_reader &reader)
+{
+	reader.read_tag("Cpa");
+	this->n_sample = reader.read_u64();
+	this->n_guess = reader.read_u64();
+	this->reset();
+	this->n = reader.read_u64();
+	reader.read(this->sx);
+	reader.read(this->sx2);
+	reader.read(this->sh);
+	reader.read(this->sh2);
+	reader.read(this->sxh);
+	if (this->sx.size() != this->n_sample || this->sx2.size() != this->n_sample
+		|| this->sh.size() != this->n_guess || this->sh2.size() != this->n_guess
+		|| this->sxh.size() != static_cast<unsigned long int>(this->n_guess)*this->n_sample)
+	{
+		fprintf(stderr, "-- ERROR: %s: inconsistent CPA sums\n", reader.get_filename().c_str());
+		std::exit(EXIT_FAILURE);
+	}
+}
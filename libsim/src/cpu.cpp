@@ -64,6 +64,8 @@ Cpu::Cpu(Options &options)
 	/* set up memory */
 	this->ram.set_size(options.mem_size);
 	this->ram.bind_tracer(&(this->tracer));
+	this->tracer.set_bit_trace(options.with_bit_leakage);
+	this->tracer.set_pc_trace(options.with_alignment || options.with_hotspots || options.sparse_buckets > 0);
 	/* set up registers */
 	for (unsigned int i = 0; i < 15; i++)
 	{
@@ -254,6 +256,96 @@ std::vector<unsigned int> Cpu::get_pwr_trace(void)
 }
 
 
+std::vector<uint32_t> Cpu::get_pwr_bit_trace(void)
+{
+	return this->tracer.get_bit_trace();
+}
+
+
+std::vector<uint32_t> Cpu::get_pwr_pc_trace(void)
+{
+	return this->tracer.get_pc_trace();
+}
+
+
+std::vector<const char *> Cpu::get_pwr_source_trace(void)
+{
+	return this->tracer.get_source_trace();
+}
+
+
+/* architectural state and memory, i.e. everything the leakage of the next
+   instructions depends on */
+void Cpu::save(State_writer &writer)
+{
+	std::vector<uint32_t> regs;
+
+	for (unsigned int i = 0; i < 15; i++)
+	{
+		regs.push_back(this->regs[i].read());
+	}
+	regs.push_back(this->pc);
+	regs.push_back(this->reg_a.read());
+	regs.push_back(this->reg_b.read());
+	for (unsigned int i = 0; i < 5; i++)
+	{
+		regs.push_back(this->flags[i]);
+	}
+	regs.push_back(this->itstate);
+	writer.write_tag("Cpu");
+	writer.write(regs);
+	writer.write_u64(this->instruction_count);
+	this->ram.save(writer);
+}
+
+
+void Cpu::load(State_reader &reader)
+{
+	std::vector<uint32_t> regs;
+
+	reader.read_tag("Cpu");
+	reader.read(regs);
+	if (regs.size() != 24)
+	{
+		fprintf(stderr, "-- ERROR: %s: inconsistent cpu state\n", reader.get_filename().c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	for (unsigned int i = 0; i < 15; i++)
+	{
+		this->regs[i].write_notrace(regs[i]);
+	}
+	this->pc = regs[15];
+	this->reg_a.write_notrace(regs[16]);
+	this->reg_b.write_notrace(regs[17]);
+	for (unsigned int i = 0; i < 5; i++)
+	{
+		this->flags[i] = regs[18 + i];
+	}
+	this->itstate = regs[23];
+	this->instruction_count = reader.read_u64();
+	this->ram.load(reader);
+}
+
+
+/* same state as Cpu::save/load, copied from a cpu with the same memory size */
+void Cpu::copy_state(Cpu &other)
+{
+	for (unsigned int i = 0; i < 15; i++)
+	{
+		this->regs[i].write_notrace(other.regs[i].read());
+	}
+	this->pc = other.pc;
+	this->reg_a.write_notrace(other.reg_a.read());
+	this->reg_b.write_notrace(other.reg_b.read());
+	for (unsigned int i = 0; i < 5; i++)
+	{
+		this->flags[i] = other.flags[i];
+	}
+	this->itstate = other.itstate;
+	this->instruction_count = other.instruction_count;
+	this->ram.copy(other.ram);
+}
+
 Step_status Cpu::step(void)
 {
 	Step_status status = STEP_DONE;
@@ -481,7 +573,8 @@ unsigned long int Cpu::run(uint32_t from, uint32_t until, unsigned long int limi
 		trace_index_file = fopen(this->trace_index_filename.c_str(), "w");
 	}
 
-	/* prepare to jump to code */
+	/* prepare to jump to code. Writing LR is attributed to the return address */
+	this->tracer.set_pc(until);
 	this->regs[LR].write(until);
 	this->pc = from;
 
@@ -500,6 +593,7 @@ unsigned long int Cpu::run(uint32_t from, uint32_t until, unsigned long int limi
 			{
 				break;
 			}
+			this->tracer.set_pc(p_addr);
 			if (this->step() == STEP_BKPT)
 			{
 				/* instruction was a breakpoint */
@@ -40,6 +40,7 @@
 #include "memory.h"
 #include "flag.h"
 #include "options.h"
+#include "state_file.h"
 
 #define R0 0
 #define R1 1
@@ -163,6 +164,12 @@ class Cpu
 		void copy_array_from_target(uint32_t *buffer, unsigned int len, uint32_t target_addr);
 		void reset_pwr_trace(void);
 		std::vector<unsigned int> get_pwr_trace(void);
+		std::vector<uint32_t> get_pwr_bit_trace(void);
+		std::vector<uint32_t> get_pwr_pc_trace(void);
+		std::vector<const char *> get_pwr_source_trace(void);
+		void save(State_writer &writer);
+		void load(State_reader &reader);
+		void copy_state(Cpu &other);
 
 };
 
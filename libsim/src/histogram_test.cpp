@@ -0,0 +1,345 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Histogram chi-square test
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include "histogram_test.h"
+
+#define MAX_PENDING UINT32_MAX
+/* size of the histograms of a block of update_batch() */
+#define BLOCK_BYTES 262144
+#define GAMMA_EPS 1e-15
+#define GAMMA_MAX_ITER 1000
+
+
+Histogram_test::Histogram_test(unsigned int n_sample, unsigned int n_bin)
+{
+	this->n_sample = n_sample;
+	this->n_bin = n_bin;
+	this->reset();
+}
+
+Histogram_test::~Histogram_test()
+{
+}
+
+void Histogram_test::reset(void)
+{
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->n[cls] = 0;
+		this->n_pending[cls] = 0;
+		this->counts[cls].assign(static_cast<unsigned long int>(this->n_bin)*this->n_sample, 0);
+		this->totals[cls].clear();
+	}
+}
+
+void Histogram_test::flush(unsigned int cls)
+{
+	if (this->totals[cls].empty())
+	{
+		this->totals[cls].assign(this->counts[cls].size(), 0);
+	}
+	for (unsigned long int k = 0; k < this->counts[cls].size(); ++k)
+	{
+		this->totals[cls][k] += this->counts[cls][k];
+	}
+	this->counts[cls].assign(this->counts[cls].size(), 0);
+	this->n_pending[cls] = 0;
+}
+
+void Histogram_test::update(unsigned int cls, const std::vector<unsigned int> &vec)
+{
+	uint32_t *h = this->counts[cls].data();
+
+	for (unsigned int i = 0; i < this->n_sample; ++i, h += this->n_bin)
+	{
+		if (vec[i] >= this->n_bin)
+		{
+			fprintf(stderr, "-- ERROR: sample value %u does not fit in %u histogram bins\n", vec[i], this->n_bin);
+			std::exit(EXIT_FAILURE);
+		}
+		h[vec[i]]++;
+	}
+	this->n[cls]++;
+	if (++this->n_pending[cls] == MAX_PENDING)
+	{
+		this->flush(cls);
+	}
+}
+
+void Histogram_test::update1(const std::vector<unsigned int> &vec)
+{
+	this->update(0, vec);
+}
+
+void Histogram_test::update2(const std::vector<unsigned int> &vec)
+{
+	this->update(1, vec);
+}
+
+/* adds the samples [i_first, i_last) of the n_trace rows of batch */
+void Histogram_test::add_batch(unsigned int cls, const uint8_t *batch, unsigned int n_trace, const unsigned int *weight,
+	unsigned int i_first, unsigned int i_last)
+{
+	unsigned int block = BLOCK_BYTES/(sizeof(uint32_t)*this->n_bin);
+
+	block = (block > 0) ? block : 1;
+	for (unsigned int i0 = i_first; i0 < i_last; i0 += block)
+	{
+		unsigned int i1 = (i0 + block < i_last) ? i0 + block : i_last;
+		for (unsigned int t = 0; t < n_trace; ++t)
+		{
+			const uint8_t *x = batch + static_cast<unsigned long int>(t)*this->n_sample;
+			uint32_t w = (weight != nullptr) ? weight[t] : 1;
+			uint32_t *h = this->counts[cls].data() + static_cast<unsigned long int>(i0)*this->n_bin;
+			for (unsigned int i = i0; i < i1; ++i, h += this->n_bin)
+			{
+				if (x[i] >= this->n_bin)
+				{
+					fprintf(stderr, "-- ERROR: sample value %u does not fit in %u histogram bins\n", x[i], this->n_bin);
+					std::exit(EXIT_FAILURE);
+				}
+				h[x[i]] += w;
+			}
+		}
+	}
+}
+
+/* The traces are the rows of the (n_trace x n_sample) matrix batch, row t
+   standing for weight[t] identical traces (1 if weight is nullptr). The
+   histograms are updated by blocks of samples with all the traces of the
+   batch, so that the histograms of a block stay in cache. With a pool, each
+   thread updates its slice of the samples */
+void Histogram_test::update_batch(unsigned int cls, const uint8_t *batch, unsigned int n_trace, const unsigned int *weight,
+	Sample_pool *pool)
+{
+	while (n_trace > 0)
+	{
+		/* rows whose weights fit in the 32-bit counters */
+		unsigned int n_chunk = 0;
+		unsigned long int w_chunk = 0;
+		for (; n_chunk < n_trace; ++n_chunk)
+		{
+			unsigned int w = (weight != nullptr) ? weight[n_chunk] : 1;
+			if (w > MAX_PENDING - this->n_pending[cls] - w_chunk)
+			{
+				break;
+			}
+			w_chunk += w;
+		}
+		if (pool != nullptr)
+		{
+			pool->run(this->n_sample, [&](unsigned int i0, unsigned int i1) { this->add_batch(cls, batch, n_chunk, weight, i0, i1); });
+		}
+		else
+		{
+			this->add_batch(cls, batch, n_chunk, weight, 0, this->n_sample);
+		}
+		this->n[cls] += w_chunk;
+		this->n_pending[cls] += w_chunk;
+		if (this->n_pending[cls] == MAX_PENDING || n_chunk < n_trace)
+		{
+			this->flush(cls);
+		}
+		batch += static_cast<unsigned long int>(n_chunk)*this->n_sample;
+		weight = (weight != nullptr) ? weight + n_chunk : nullptr;
+		n_trace -= n_chunk;
+	}
+}
+
+void Histogram_test::update1_batch(const uint8_t *batch, unsigned int n_trace, const unsigned int *weight, Sample_pool *pool)
+{
+	this->update_batch(0, batch, n_trace, weight, pool);
+}
+
+void Histogram_test::update2_batch(const uint8_t *batch, unsigned int n_trace, const unsigned int *weight, Sample_pool *pool)
+{
+	this->update_batch(1, batch, n_trace, weight, pool);
+}
+
+void Histogram_test::merge(const Histogram_test &other)
+{
+	if (other.n_sample != this->n_sample || other.n_bin != this->n_bin)
+	{
+		fprintf(stderr, "-- ERROR: can not merge histogram tests of %u samples x %u bins and %u samples x %u bins\n",
+			this->n_sample, this->n_bin, other.n_sample, other.n_bin);
+		std::exit(EXIT_FAILURE);
+	}
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		if (this->totals[cls].empty())
+		{
+			this->totals[cls].assign(this->counts[cls].size(), 0);
+		}
+		for (unsigned long int k = 0; k < this->totals[cls].size(); ++k)
+		{
+			this->totals[cls][k] += other.counts[cls][k] + (other.totals[cls].empty() ? 0 : other.totals[cls][k]);
+		}
+		this->n[cls] += other.n[cls];
+	}
+}
+
+void Histogram_test::save(State_writer &writer)
+{
+	writer.write_tag("Histogram_test");
+	writer.write_u64(this->n_sample);
+	writer.write_u64(this->n_bin);
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->flush(cls);
+		writer.write_u64(this->n[cls]);
+		writer.write(this->totals[cls]);
+	}
+}
+
+void Histogram_test::load(State_reader &reader)
+{
+	reader.read_tag("Histogram_test");
+	this->n_sample = reader.read_u64();
+	this->n_bin = reader.read_u64();
+	this->reset();
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->n[cls] = reader.read_u64();
+		reader.read(this->totals[cls]);
+		if (this->totals[cls].size() != static_cast<unsigned long int>(this->n_bin)*this->n_sample)
+		{
+			fprintf(stderr, "-- ERROR: %s: inconsistent histograms\n", reader.get_filename().c_str());
+			std::exit(EXIT_FAILURE);
+		}
+	}
+}
+
+/* bin k of class cls, the pending counts included */
+uint64_t Histogram_test::count(unsigned int cls, unsigned long int k) const
+{
+	return this->counts[cls][k] + (this->totals[cls].empty() ? 0 : this->totals[cls][k]);
+}
+
+/* -log10 of the upper tail of the chi-square distribution with dof degrees of
+   freedom, i.e. of the regularized gamma function Q(dof/2, chi2/2): series of
+   P = 1 - Q below a + 1, continued fraction of Q (modified Lentz) above. The
+   logarithm is taken before Q underflows */
+static double chi2_log10_p(double chi2, unsigned int dof)
+{
+	double a = 0.5*dof;
+	double x = 0.5*chi2;
+
+	if (dof == 0 || x <= 0.0)
+	{
+		return 0.0;
+	}
+	double log_prefix = -x + a*log(x) - lgamma(a);
+	if (x < a + 1.0)
+	{
+		double term = 1.0/a;
+		double sum = term;
+		for (unsigned int k = 1; k < GAMMA_MAX_ITER && fabs(term) > fabs(sum)*GAMMA_EPS; ++k)
+		{
+			term *= x/(a + k);
+			sum += term;
+		}
+		double q = 1.0 - exp(log_prefix)*sum;
+		return (q > 0.0) ? -log10(q) : 0.0;
+	}
+	double tiny = 1e-300;
+	double b = x + 1.0 - a;
+	double c = 1.0/tiny;
+	double d = 1.0/b;
+	double h = d;
+	for (unsigned int k = 1; k < GAMMA_MAX_ITER; ++k)
+	{
+		double an = -(k*(k - a));
+		b += 2.0;
+		d = an*d + b;
+		d = (fabs(d) < tiny) ? tiny : d;
+		c = b + an/c;
+		c = (fabs(c) < tiny) ? tiny : c;
+		d = 1.0/d;
+		h *= d*c;
+		if (fabs(d*c - 1.0) < GAMMA_EPS)
+		{
+			break;
+		}
+	}
+	return -(log_prefix + log(h))/log(10.0);
+}
+
+/* Pearson chi-square statistic of the 2 x n_bin contingency table (class,
+   sample value) of each sample, empty bins left out. Returns -log10(p), which
+   is comparable across samples whatever their number of non-empty bins: 5 is
+   about the p-value of |t| = 4.5 */
+std::vector<double> Histogram_test::chi2_test(void)
+{
+	std::vector<double> log_p;
+	double n1 = this->n[0];
+	double n2 = this->n[1];
+	double n_total = n1 + n2;
+
+	if (n1 == 0.0 || n2 == 0.0)
+	{
+		return std::vector<double>(this->n_sample, 0.0);
+	}
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		unsigned long int offset = static_cast<unsigned long int>(i)*this->n_bin;
+		double chi2 = 0.0;
+		unsigned int n_nonempty = 0;
+
+		for (unsigned int v = 0; v < this->n_bin; ++v)
+		{
+			double o1 = this->count(0, offset + v);
+			double o2 = this->count(1, offset + v);
+			if (o1 + o2 == 0.0)
+			{
+				continue;
+			}
+			double e1 = n1*(o1 + o2)/n_total;
+			double e2 = n2*(o1 + o2)/n_total;
+			chi2 += (o1 - e1)*(o1 - e1)/e1 + (o2 - e2)*(o2 - e2)/e2;
+			n_nonempty++;
+		}
+		if (n_nonempty < 2)
+		{
+			log_p.push_back(0.0);
+		}
+		else
+		{
+			log_p.push_back(chi2_log10_p(chi2, n_nonempty - 1));
+		}
+	}
+	return log_p;
+}
@@ -0,0 +1,274 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Per-instruction leakage hotspot report
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "hotspot.h"
+
+/* samples of one (pc, source register) */
+typedef struct
+{
+	uint32_t pc;
+	std::string source;
+	std::vector<double> max_abs_t;    /* per order */
+	double max;
+	unsigned int order;
+	unsigned int sample;              /* sample of the max */
+	unsigned int n_sample;
+	uint64_t first_crossing;          /* 0: never */
+} Hotspot;
+
+
+Hotspot_report::Hotspot_report(const std::vector<uint32_t> &pc_trace, const std::vector<const char *> &source_trace, double threshold)
+{
+	this->pc_trace = pc_trace;
+	this->source_trace.assign(source_trace.begin(), source_trace.end());
+	this->threshold = threshold;
+	this->first_crossing.assign(pc_trace.size(), 0);
+}
+
+Hotspot_report::~Hotspot_report()
+{
+}
+
+const std::vector<uint32_t> &Hotspot_report::get_pc_trace(void) const
+{
+	return this->pc_trace;
+}
+
+/* t[k] is the t-test of order k + 1 on the full traces after n measures */
+void Hotspot_report::track(unsigned long int n, const std::vector<std::vector<double>> &t)
+{
+	for (auto &vec : t)
+	{
+		for (unsigned int i = 0; i < this->first_crossing.size(); ++i)
+		{
+			if (this->first_crossing[i] == 0 && fabs(vec[i]) > this->threshold)
+			{
+				this->first_crossing[i] = n;
+			}
+		}
+	}
+}
+
+static std::string json_string(const std::string &str)
+{
+	std::string out = "\"";
+
+	for (char c : str)
+	{
+		if (c == '"' || c == '\\')
+		{
+			out += '\\';
+			out += c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20)
+		{
+			char buffer[8];
+			snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+			out += buffer;
+		}
+		else
+		{
+			out += c;
+		}
+	}
+	return out + "\"";
+}
+
+/* hotspots ranked by decreasing max |t| over all orders */
+void Hotspot_report::write(std::string txt_filename, std::string json_filename, std::string name, unsigned long int n_measure,
+	const std::vector<std::vector<double>> &t, const std::map<uint32_t, std::string> &disassembly)
+{
+	std::map<std::pair<uint32_t, std::string>, unsigned int> index;
+	std::vector<Hotspot> hotspots;
+
+	this->track(n_measure, t);
+	for (unsigned int i = 0; i < this->pc_trace.size(); ++i)
+	{
+		auto key = std::make_pair(this->pc_trace[i], this->source_trace[i]);
+		auto it = index.find(key);
+		if (it == index.end())
+		{
+			it = index.insert(std::make_pair(key, hotspots.size())).first;
+			hotspots.push_back({this->pc_trace[i], this->source_trace[i], std::vector<double>(t.size(), 0.0), 0.0, 1, i, 0, 0});
+		}
+		Hotspot &h = hotspots[it->second];
+		h.n_sample++;
+		for (unsigned int k = 0; k < t.size(); ++k)
+		{
+			double a = fabs(t[k][i]);
+			h.max_abs_t[k] = (a > h.max_abs_t[k]) ? a : h.max_abs_t[k];
+			if (a > h.max)
+			{
+				h.max = a;
+				h.order = k + 1;
+				h.sample = i;
+			}
+		}
+		if (this->first_crossing[i] > 0 && (h.first_crossing == 0 || this->first_crossing[i] < h.first_crossing))
+		{
+			h.first_crossing = this->first_crossing[i];
+		}
+	}
+	std::stable_sort(hotspots.begin(), hotspots.end(), [](const Hotspot &a, const Hotspot &b) { return a.max > b.max; });
+
+	FILE *txt = fopen(txt_filename.c_str(), "w");
+	FILE *json = fopen(json_filename.c_str(), "w");
+	if (txt == NULL || json == NULL)
+	{
+		fprintf(stderr, "-- ERROR: can not write the hotspot report %s\n", (txt == NULL) ? txt_filename.c_str() : json_filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	fprintf(txt, "-- leakage hotspots of %s after %lu measurements, threshold %.1f\n", name.c_str(), n_measure, this->threshold);
+	fprintf(txt, "%5s  %-10s  %-6s  %10s  %5s  %8s  %7s  %14s  %s\n",
+		"rank", "pc", "source", "max|t|", "order", "sample", "samples", "first crossing", "instruction");
+	fprintf(json, "{\n\t\"sec_algo\": %s,\n\t\"n_measure\": %lu,\n\t\"threshold\": %.17g,\n\t\"hotspots\": [",
+		json_string(name).c_str(), n_measure, this->threshold);
+	for (unsigned int r = 0; r < hotspots.size(); ++r)
+	{
+		const Hotspot &h = hotspots[r];
+		auto it = disassembly.find(h.pc);
+		std::string instruction = (it == disassembly.end()) ? "" : it->second;
+		std::string first_crossing = (h.first_crossing == 0) ? "-" : std::to_string(h.first_crossing);
+
+		fprintf(txt, "%5u  0x%08x  %-6s  %10.2f  %5u  %8u  %7u  %14s  %s\n", r + 1, h.pc, h.source.c_str(), h.max, h.order,
+			h.sample, h.n_sample, first_crossing.c_str(), instruction.c_str());
+		fprintf(json, "%s\n\t\t{\"rank\": %u, \"pc\": %u, \"source\": %s, \"instruction\": %s, \"max_abs_t\": [",
+			(r == 0) ? "" : ",", r + 1, h.pc, json_string(h.source).c_str(), json_string(instruction).c_str());
+		for (unsigned int k = 0; k < h.max_abs_t.size(); ++k)
+		{
+			fprintf(json, "%s%.17g", (k == 0) ? "" : ", ", h.max_abs_t[k]);
+		}
+		fprintf(json, "], \"order\": %u, \"sample\": %u, \"n_sample\": %u, \"first_crossing\": %s}",
+			h.order, h.sample, h.n_sample, (h.first_crossing == 0) ? "null" : first_crossing.c_str());
+	}
+	fprintf(json, "\n\t]\n}\n");
+	fclose(txt);
+	fclose(json);
+}
+
+void Hotspot_report::save(State_writer &writer)
+{
+	std::string sources;
+
+	for (auto &source : this->source_trace)
+	{
+		sources += source + ",";
+	}
+	writer.write_tag("Hotspot_report");
+	writer.write_f64(this->threshold);
+	writer.write(this->pc_trace);
+	writer.write_string(sources);
+	writer.write(this->first_crossing);
+}
+
+void Hotspot_report::load(State_reader &reader)
+{
+	std::istringstream sources;
+	std::string source;
+
+	reader.read_tag("Hotspot_report");
+	this->threshold = reader.read_f64();
+	reader.read(this->pc_trace);
+	sources.str(reader.read_string());
+	this->source_trace.clear();
+	while (std::getline(sources, source, ','))
+	{
+		this->source_trace.push_back(source);
+	}
+	reader.read(this->first_crossing);
+	if (this->source_trace.size() != this->pc_trace.size() || this->first_crossing.size() != this->pc_trace.size())
+	{
+		fprintf(stderr, "-- ERROR: %s: inconsistent hotspot report\n", reader.get_filename().c_str());
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+/* instructions of the .text section of an objdump listing (the .lst files of
+   the firmware builds), by address. Empty if the file can not be read */
+std::map<uint32_t, std::string> read_listing(std::string filename)
+{
+	std::map<uint32_t, std::string> listing;
+	FILE *file = fopen(filename.c_str(), "r");
+	char line[512];
+	bool in_text = false;
+
+	if (file == NULL)
+	{
+		return listing;
+	}
+	/* "     addr:\tencoding \tmnemonic\toperands" */
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		std::vector<std::string> fields;
+		std::istringstream stream(line);
+		std::string field;
+		unsigned int addr;
+		char colon;
+
+		if (strncmp(line, "Disassembly of section ", 23) == 0)
+		{
+			in_text = (strncmp(line + 23, ".text:", 6) == 0);
+			continue;
+		}
+		if (!in_text)
+		{
+			continue;
+		}
+		while (std::getline(stream, field, '\t'))
+		{
+			field.erase(field.find_last_not_of(" \n") + 1);
+			fields.push_back(field);
+		}
+		if (fields.size() < 3 || sscanf(fields[0].c_str(), " %x%c", &addr, &colon) != 2 || colon != ':')
+		{
+			continue;
+		}
+		std::string instruction = fields[2];
+		for (unsigned int k = 3; k < fields.size(); ++k)
+		{
+			instruction += " " + fields[k];
+		}
+		listing[addr] = instruction;
+	}
+	fclose(file);
+	return listing;
+}
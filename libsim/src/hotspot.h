@@ -0,0 +1,67 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Per-instruction leakage hotspot report
+ *
+ ******************************************************************************/
+
+#ifndef __HOTSPOT_H__
+#define __HOTSPOT_H__
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "state_file.h"
+
+/* Reduces the univariate t-tests (orders 1 to d) per (pc, source register)
+   of the samples, using the instruction and the register of each event of
+   the traces. The first crossing of a sample is the number of measures of
+   the first evaluation at which |t| exceeded the threshold in any order */
+class Hotspot_report
+{
+	private:
+		std::vector<uint32_t> pc_trace;
+		std::vector<std::string> source_trace;
+		double threshold;
+		std::vector<uint64_t> first_crossing;   /* per sample, 0: never */
+
+	public:
+		Hotspot_report(const std::vector<uint32_t> &pc_trace, const std::vector<const char *> &source_trace, double threshold);
+		~Hotspot_report();
+		const std::vector<uint32_t> &get_pc_trace(void) const;
+		void track(unsigned long int n, const std::vector<std::vector<double>> &t);
+		void write(std::string txt_filename, std::string json_filename, std::string name, unsigned long int n_measure,
+			const std::vector<std::vector<double>> &t, const std::map<uint32_t, std::string> &disassembly);
+		void save(State_writer &writer);
+		void load(State_reader &reader);
+};
+
+std::map<uint32_t, std::string> read_listing(std::string filename);
+
+#endif
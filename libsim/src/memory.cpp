@@ -32,6 +32,9 @@
 
 #include <fstream>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
 
 #include "memory.h"
 #include "tracer.h"
@@ -90,8 +93,7 @@ void Memory::write32(uint32_t addr, uint32_t val)
 		std::exit(EXIT_FAILURE);
 	}
 	this->mem32[addr >> 2] = val;
-	unsigned int pwr = bit_count(val);
-	this->tracer_ptr->update(pwr);
+	this->tracer_ptr->update(val, "mem");
 }
 
 
@@ -114,8 +116,7 @@ void Memory::write16(uint32_t addr, uint16_t val)
 		std::exit(EXIT_FAILURE);
 	}
 	this->mem16[addr >> 1] = val;
-	unsigned int pwr = bit_count(val);
-	this->tracer_ptr->update(pwr);
+	this->tracer_ptr->update(val, "mem");
 }
 
 
@@ -138,8 +139,7 @@ void Memory::write8(uint32_t addr, uint8_t val)
 		std::exit(EXIT_FAILURE);
 	}
 	this->mem8[addr] = val;
-	unsigned int pwr = bit_count(val);
-	this->tracer_ptr->update(pwr);
+	this->tracer_ptr->update(val, "mem");
 }
 
 
@@ -162,8 +162,7 @@ uint32_t Memory::read32(uint32_t addr)
 		std::exit(EXIT_FAILURE);
 	}
 	uint32_t ret = this->mem32[addr >> 2];
-	unsigned int pwr = bit_count(ret);
-	this->tracer_ptr->update(pwr);
+	this->tracer_ptr->update(ret, "mem");
 	return ret;
 }
 
@@ -188,8 +187,7 @@ uint16_t Memory::read16(uint32_t addr)
 		std::exit(EXIT_FAILURE);
 	}
 	uint16_t ret = this->mem16[addr >> 1];
-	unsigned int pwr = bit_count(ret);
-	this->tracer_ptr->update(pwr);
+	this->tracer_ptr->update(ret, "mem");
 	return ret;
 }
 
@@ -214,8 +212,7 @@ uint8_t Memory::read8(uint32_t addr)
 		std::exit(EXIT_FAILURE);
 	}
 	uint8_t ret = this->mem8[addr];
-	unsigned int pwr = bit_count(ret);
-	this->tracer_ptr->update(pwr);
+	this->tracer_ptr->update(ret, "mem");
 	return ret;
 }
 
@@ -276,3 +273,45 @@ void Memory::dump(uint32_t start, uint32_t len)
 		}
 	}
 }
+
+
+/* the whole content, as 32-bit words */
+void Memory::save(State_writer &writer) const
+{
+	std::vector<uint32_t> words((this->size + 3)/4, 0);
+
+	memcpy(words.data(), this->mem8, this->size);
+	writer.write_tag("Memory");
+	writer.write_u64(this->size);
+	writer.write(words);
+}
+
+void Memory::load(State_reader &reader)
+{
+	std::vector<uint32_t> words;
+
+	reader.read_tag("Memory");
+	if (reader.read_u64() != this->size)
+	{
+		fprintf(stderr, "-- ERROR: %s: memory size differs from %u bytes\n", reader.get_filename().c_str(), this->size);
+		std::exit(EXIT_FAILURE);
+	}
+	reader.read(words);
+	if (words.size() != (this->size + 3)/4)
+	{
+		fprintf(stderr, "-- ERROR: %s: inconsistent memory content\n", reader.get_filename().c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	memcpy(this->mem8, words.data(), this->size);
+}
+
+/* content of a memory of the same size */
+void Memory::copy(const Memory &other)
+{
+	if (other.size != this->size)
+	{
+		fprintf(stderr, "-- ERROR: memory size differs from %u bytes\n", this->size);
+		std::exit(EXIT_FAILURE);
+	}
+	memcpy(this->mem8, other.mem8, this->size);
+}
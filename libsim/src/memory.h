@@ -35,6 +35,7 @@
 
 #include <cstdint>
 #include "tracer.h"
+#include "state_file.h"
 
 class Memory
 {
@@ -65,6 +66,9 @@ class Memory
 		uint8_t read8_notrace(uint32_t addr);
 		int load(const char *filename);
 		void dump(uint32_t start, uint32_t len);
+		void save(State_writer &writer) const;
+		void load(State_reader &reader);
+		void copy(const Memory &other);
 };
 
 #endif
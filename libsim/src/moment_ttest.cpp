@@ -0,0 +1,377 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Higher-order univariate t-test
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include "moment_ttest.h"
+
+/* size of the means and central sums of a block of update_batch() */
+#define BLOCK_BYTES 32768
+
+Moment_ttest::Moment_ttest(unsigned int n_sample, unsigned int max_order)
+{
+	this->n_sample = n_sample;
+	this->max_order = (max_order < 1) ? 1 : max_order;
+	this->n_cs = 2*this->max_order - 1;
+	this->init_binomial();
+	this->reset();
+}
+
+Moment_ttest::~Moment_ttest()
+{
+}
+
+void Moment_ttest::init_binomial(void)
+{
+	unsigned int max_p = this->n_cs + 2;
+	this->binomial.assign(max_p*max_p, 0.0);
+	for (unsigned int p = 0; p < max_p; ++p)
+	{
+		this->binomial[p*max_p] = 1.0;
+		for (unsigned int k = 1; k <= p; ++k)
+		{
+			this->binomial[p*max_p + k] = this->binomial[(p - 1)*max_p + k - 1] + ((k < p) ? this->binomial[(p - 1)*max_p + k] : 0.0);
+		}
+	}
+}
+
+void Moment_ttest::reset(void)
+{
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->n[cls] = 0;
+		this->mean[cls].assign(this->n_sample, 0.0);
+		this->cs[cls].assign(this->n_cs*this->n_sample, 0.0);
+	}
+}
+
+/* append a sample that had the same value in all the traces seen so far */
+void Moment_ttest::add_constant_sample(double value)
+{
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->mean[cls].push_back(value);
+		this->cs[cls].resize(this->cs[cls].size() + this->n_cs, 0.0);
+	}
+	this->n_sample++;
+}
+
+/* factor[p] = 1/w^(p - 1) - (-1/(count - w))^(p - 1), p = 2..n_cs + 1 */
+void Moment_ttest::init_factor(double count, double weight, double *factor) const
+{
+	for (unsigned int p = 2; p <= this->n_cs + 1; ++p)
+	{
+		factor[p] = (count > weight) ? pow(weight, 1.0 - p) - pow(-1.0/(count - weight), p - 1) : 0.0;
+	}
+}
+
+/* Adds w values x to sample i of class cls (the merge of a set of w identical
+   values, see merge()). With delta = x - mean and n the new count:
+   CS_p += sum_{k=1}^{p-2} C(p, k) CS_{p-k} (-w delta/n)^k
+         + ((n - w) w delta/n)^p (1/w^(p - 1) - (-1/(n - w))^(p - 1))
+   p is processed in decreasing order so that CS_{p-k} are the old values */
+inline void Moment_ttest::update_sample(unsigned int cls, unsigned int i, double x, double count, double weight,
+	const double *factor)
+{
+	unsigned int max_p = this->n_cs + 1;
+	unsigned int stride = this->n_cs + 2;
+	double *cs = this->cs[cls].data() + i*this->n_cs;    /* CS_p at cs[p - 2] */
+	double delta = x - this->mean[cls][i];
+	double d_n = -weight*delta/count;
+	double a = (count - weight)*weight*delta/count;
+
+	for (unsigned int p = max_p; p >= 2; --p)
+	{
+		double s = cs[p - 2];
+		double power = 1.0;
+		for (unsigned int k = 1; k + 2 <= p; ++k)
+		{
+			power *= d_n;
+			s += this->binomial[p*stride + k]*cs[p - k - 2]*power;
+		}
+		s += pow(a, p)*factor[p];
+		cs[p - 2] = s;
+	}
+	this->mean[cls][i] += weight*delta/count;
+}
+
+void Moment_ttest::update(unsigned int cls, const std::vector<unsigned int> &vec)
+{
+	double count = this->n[cls] + 1;
+	std::vector<double> factor(this->n_cs + 2);
+
+	this->init_factor(count, 1.0, factor.data());
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		this->update_sample(cls, i, static_cast<double>(vec[i]), count, 1.0, factor.data());
+	}
+	this->n[cls]++;
+}
+
+/* adds the samples [i_first, i_last) of the n_trace rows of batch, with the
+   count after each row in count and its factors in factor */
+void Moment_ttest::add_batch(unsigned int cls, const uint8_t *batch, unsigned int n_trace, const unsigned int *weight,
+	const double *count, const double *factor, unsigned int i_first, unsigned int i_last)
+{
+	unsigned int stride = this->n_cs + 2;
+	unsigned int block = BLOCK_BYTES/(sizeof(double)*(this->n_cs + 1));
+
+	block = (block > 0) ? block : 1;
+	for (unsigned int i0 = i_first; i0 < i_last; i0 += block)
+	{
+		unsigned int i1 = (i0 + block < i_last) ? i0 + block : i_last;
+		for (unsigned int t = 0; t < n_trace; ++t)
+		{
+			const uint8_t *x = batch + static_cast<unsigned long int>(t)*this->n_sample;
+			double w = (weight != nullptr) ? weight[t] : 1.0;
+			for (unsigned int i = i0; i < i1; ++i)
+			{
+				this->update_sample(cls, i, static_cast<double>(x[i]), count[t], w, factor + t*stride);
+			}
+		}
+	}
+}
+
+/* The traces are the rows of the (n_trace x n_sample) matrix batch, row t
+   standing for weight[t] identical traces (1 if weight is nullptr). Each
+   sample sees the rows in the same order as with update1() and update2(),
+   but the means and central sums are updated by blocks of samples that stay
+   in cache. With a pool, each thread updates its slice of the samples */
+void Moment_ttest::update_batch(unsigned int cls, const uint8_t *batch, unsigned int n_trace, const unsigned int *weight,
+	Sample_pool *pool)
+{
+	unsigned int stride = this->n_cs + 2;
+	std::vector<double> count(n_trace);
+	std::vector<double> factor(static_cast<unsigned long int>(n_trace)*stride);
+	unsigned long int n = this->n[cls];
+
+	for (unsigned int t = 0; t < n_trace; ++t)
+	{
+		unsigned int w = (weight != nullptr) ? weight[t] : 1;
+		n += w;
+		count[t] = n;
+		this->init_factor(count[t], w, factor.data() + t*stride);
+	}
+	if (pool != nullptr)
+	{
+		pool->run(this->n_sample, [&](unsigned int i0, unsigned int i1)
+			{ this->add_batch(cls, batch, n_trace, weight, count.data(), factor.data(), i0, i1); });
+	}
+	else
+	{
+		this->add_batch(cls, batch, n_trace, weight, count.data(), factor.data(), 0, this->n_sample);
+	}
+	this->n[cls] = n;
+}
+
+void Moment_ttest::update1(const std::vector<unsigned int> &vec)
+{
+	this->update(0, vec);
+}
+
+void Moment_ttest::update2(const std::vector<unsigned int> &vec)
+{
+	this->update(1, vec);
+}
+
+void Moment_ttest::update1_batch(const uint8_t *batch, unsigned int n_trace, const unsigned int *weight, Sample_pool *pool)
+{
+	this->update_batch(0, batch, n_trace, weight, pool);
+}
+
+void Moment_ttest::update2_batch(const uint8_t *batch, unsigned int n_trace, const unsigned int *weight, Sample_pool *pool)
+{
+	this->update_batch(1, batch, n_trace, weight, pool);
+}
+
+/* back to the full trace: sample k goes to remap[k], the other samples had
+   the value constant_value[i] in every trace */
+void Moment_ttest::expand(const std::vector<unsigned int> &remap, const std::vector<unsigned int> &constant_value)
+{
+	unsigned int n_full = constant_value.size();
+
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		std::vector<double> mean(constant_value.begin(), constant_value.end());
+		std::vector<double> cs(this->n_cs*n_full, 0.0);
+		for (unsigned int j = 0; j < this->n_sample; ++j)
+		{
+			mean[remap[j]] = this->mean[cls][j];
+			for (unsigned int p = 0; p < this->n_cs; ++p)
+			{
+				cs[remap[j]*this->n_cs + p] = this->cs[cls][j*this->n_cs + p];
+			}
+		}
+		this->mean[cls].swap(mean);
+		this->cs[cls].swap(cs);
+	}
+	this->n_sample = n_full;
+}
+
+/* Pebay's generalization of the Chan et al. update, with delta = mean_b - mean_a:
+   CS_p = CS_p,a + CS_p,b
+        + sum_{k=1}^{p-2} C(p, k) delta^k ((-n_b/n)^k CS_{p-k},a + (n_a/n)^k CS_{p-k},b)
+        + (n_a n_b delta/n)^p (1/n_b^(p-1) - (-1/n_a)^(p-1)) */
+void Moment_ttest::merge(const Moment_ttest &other)
+{
+	unsigned int max_p = this->n_cs + 1;
+	unsigned int stride = this->n_cs + 2;
+
+	if (other.n_sample != this->n_sample || other.max_order != this->max_order)
+	{
+		fprintf(stderr, "-- ERROR: can not merge moments of %u samples (order %u) and %u samples (order %u)\n",
+			this->n_sample, this->max_order, other.n_sample, other.max_order);
+		std::exit(EXIT_FAILURE);
+	}
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		if (other.n[cls] == 0)
+		{
+			continue;
+		}
+		if (this->n[cls] == 0)
+		{
+			this->n[cls] = other.n[cls];
+			this->mean[cls] = other.mean[cls];
+			this->cs[cls] = other.cs[cls];
+			continue;
+		}
+		double n_a = this->n[cls];
+		double n_b = other.n[cls];
+		double n = n_a + n_b;
+		for (unsigned int i = 0; i < this->n_sample; ++i)
+		{
+			double *cs_a = this->cs[cls].data() + i*this->n_cs;    /* CS_p at cs[p - 2] */
+			const double *cs_b = other.cs[cls].data() + i*this->n_cs;
+			double delta = other.mean[cls][i] - this->mean[cls][i];
+			for (unsigned int p = max_p; p >= 2; --p)
+			{
+				double s = cs_a[p - 2] + cs_b[p - 2];
+				double power_a = 1.0;
+				double power_b = 1.0;
+				for (unsigned int k = 1; k + 2 <= p; ++k)
+				{
+					power_a *= -n_b*delta/n;
+					power_b *= n_a*delta/n;
+					s += this->binomial[p*stride + k]*(power_a*cs_a[p - k - 2] + power_b*cs_b[p - k - 2]);
+				}
+				s += pow(n_a*n_b*delta/n, p)*(1.0/pow(n_b, p - 1) - pow(-1.0/n_a, p - 1));
+				cs_a[p - 2] = s;
+			}
+			this->mean[cls][i] += delta*n_b/n;
+		}
+		this->n[cls] += other.n[cls];
+	}
+}
+
+void Moment_ttest::save(State_writer &writer) const
+{
+	writer.write_tag("Moment_ttest");
+	writer.write_u64(this->n_sample);
+	writer.write_u64(this->max_order);
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		writer.write_u64(this->n[cls]);
+		writer.write(this->mean[cls]);
+		writer.write(this->cs[cls]);
+	}
+}
+
+void Moment_ttest::load(State_reader &reader)
+{
+	reader.read_tag("Moment_ttest");
+	this->n_sample = reader.read_u64();
+	this->max_order = reader.read_u64();
+	this->n_cs = 2*this->max_order - 1;
+	this->init_binomial();
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->n[cls] = reader.read_u64();
+		reader.read(this->mean[cls]);
+		reader.read(this->cs[cls]);
+		if (this->mean[cls].size() != this->n_sample || this->cs[cls].size() != static_cast<unsigned long int>(this->n_cs)*this->n_sample)
+		{
+			fprintf(stderr, "-- ERROR: %s: inconsistent central moments\n", reader.get_filename().c_str());
+			std::exit(EXIT_FAILURE);
+		}
+	}
+}
+
+/* CM_p = CS_p/n */
+double Moment_ttest::central_moment(unsigned int cls, unsigned int i, unsigned int p) const
+{
+	return this->cs[cls][i*this->n_cs + p - 2]/this->n[cls];
+}
+
+std::vector<double> Moment_ttest::t_test(unsigned int order)
+{
+	std::vector<double> t;
+	double m[2];
+	double v[2];
+
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		for (unsigned int cls = 0; cls < 2; ++cls)
+		{
+			double cm2 = this->central_moment(cls, i, 2);
+			if (order == 1)
+			{
+				m[cls] = this->mean[cls][i];
+				v[cls] = cm2*this->n[cls]/(this->n[cls] - 1);
+			}
+			else if (order == 2)
+			{
+				m[cls] = cm2;
+				v[cls] = this->central_moment(cls, i, 4) - cm2*cm2;
+			}
+			else
+			{
+				double cm_d = this->central_moment(cls, i, order);
+				m[cls] = (cm2 == 0.0) ? 0.0 : cm_d/pow(cm2, 0.5*order);
+				v[cls] = (cm2 == 0.0) ? 0.0 : (this->central_moment(cls, i, 2*order) - cm_d*cm_d)/pow(cm2, order);
+			}
+		}
+		double term = sqrt(v[0]/this->n[0] + v[1]/this->n[1]);
+		if (term == 0.0 || std::isnan(term))
+		{
+			t.push_back(0.0);
+		}
+		else
+		{
+			t.push_back((m[0] - m[1])/term);
+		}
+	}
+	return t;
+}
@@ -31,23 +31,35 @@
  ******************************************************************************/
 
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <cstdio>
 #include <vector>
 #include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "npy.h"
 
 #define MAJOR 0x01
 #define MINOR 0x00
 
-void save_npy(std::string filename, std::vector<double> vec)
+/* build the magic string, version and header. The total length is padded to
+   a multiple of align (and at least min_len) so that the data can be accessed
+   in place */
+static std::string npy_preamble(std::string descr, std::string shape, unsigned int align, unsigned int min_len = 0)
 {
-	std::ofstream file;
-	std::string header = "{'descr': '<f8', 'fortran_order': False, 'shape': (" + std::to_string(vec.size()) + ",), }";
+	std::string header = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': " + shape + ", }";
+	std::string preamble;
 
-	file.open(filename, std::ios::out | std::ios::binary);
 	unsigned int len = 10 + header.length();
-	unsigned int padding = 16 - (len % 16) - 1;
+	unsigned int padding = align - (len % align) - 1;
+	if (len + padding + 1 < min_len)
+	{
+		padding = min_len - len - 1;
+	}
 	if (padding > 0)
 	{
 		header.append(padding, ' ');
@@ -56,14 +68,313 @@ void save_npy(std::string filename, std::vector<double> vec)
 	uint16_t header_len = header.length();
 
 	/* magic */
-	file << static_cast<char>(0x93) << "NUMPY";
+	preamble.push_back(static_cast<char>(0x93));
+	preamble.append("NUMPY");
 	/* versions */
-	file << static_cast<char>(MAJOR) << static_cast<char>(MINOR);
+	preamble.push_back(static_cast<char>(MAJOR));
+	preamble.push_back(static_cast<char>(MINOR));
 	/* header */
-	file.write((char *)&header_len, sizeof(uint16_t));
-	file.write((char *)header.data(), header_len);
+	preamble.append((char *)&header_len, sizeof(uint16_t));
+	preamble.append(header);
+	return preamble;
+}
+
+static void write_npy(std::string filename, std::string shape, const std::vector<double> &vec)
+{
+	std::ofstream file;
+	std::string preamble = npy_preamble("<f8", shape, 16);
+
+	file.open(filename, std::ios::out | std::ios::binary);
+	file.write((char *)preamble.data(), preamble.length());
 	/* data */
 	file.write((char *)vec.data(), sizeof(double)*vec.size());
 
 	file.close();
 }
+
+void save_npy(std::string filename, std::vector<double> vec)
+{
+	write_npy(filename, "(" + std::to_string(vec.size()) + ",)", vec);
+}
+
+/* 2D array of vec.size()/n_col rows */
+void save_npy(std::string filename, std::vector<double> vec, unsigned long int n_col)
+{
+	write_npy(filename, "(" + std::to_string(vec.size()/n_col) + ", " + std::to_string(n_col) + ")", vec);
+}
+
+Npy_matrix::Npy_matrix(std::string filename, std::string descr, unsigned long int n_row, unsigned long int n_col)
+{
+	this->n_row = n_row;
+	this->n_col = n_col;
+	this->is_1d = false;
+	this->create(filename, descr, this->shape(n_row));
+}
+
+Npy_matrix::Npy_matrix(std::string filename, std::string descr, unsigned long int n_row)
+{
+	this->n_row = n_row;
+	this->n_col = 1;
+	this->is_1d = true;
+	this->create(filename, descr, this->shape(n_row));
+}
+
+std::string Npy_matrix::shape(unsigned long int n_row) const
+{
+	if (this->is_1d)
+	{
+		return "(" + std::to_string(n_row) + ",)";
+	}
+	return "(" + std::to_string(n_row) + ", " + std::to_string(this->n_col) + ")";
+}
+
+void Npy_matrix::create(std::string filename, std::string descr, std::string shape)
+{
+	std::string preamble = npy_preamble(descr, shape, 64);
+
+	/* write_row() converts to these types only */
+	if (descr != "|u1" && descr != "<u2" && descr != "<u4")
+	{
+		fprintf(stderr, "-- ERROR: can not create %s with type %s ('|u1', '<u2' or '<u4' expected)\n", filename.c_str(), descr.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	this->filename = filename;
+	this->descr = descr;
+	this->item_size = strtoul(descr.c_str() + 2, NULL, 10);
+	this->data_offset = preamble.length();
+	this->map_len = this->data_offset + this->item_size*this->n_row*this->n_col;
+
+	this->fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (this->fd < 0)
+	{
+		fprintf(stderr, "-- ERROR: can not create %s\n", filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	if (ftruncate(this->fd, this->map_len) < 0)
+	{
+		fprintf(stderr, "-- ERROR: can not resize %s to %lu bytes\n", filename.c_str(), this->map_len);
+		std::exit(EXIT_FAILURE);
+	}
+	void *ptr = mmap(NULL, this->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+	if (ptr == MAP_FAILED)
+	{
+		fprintf(stderr, "-- ERROR: can not map %s\n", filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	this->map = static_cast<uint8_t *>(ptr);
+	memcpy(this->map, preamble.data(), preamble.length());
+}
+
+/* keep the first n_row rows only, e.g. when a campaign stops early. The
+   header keeps its length so that the data does not move */
+void Npy_matrix::truncate(unsigned long int n_row)
+{
+	if (n_row >= this->n_row)
+	{
+		return;
+	}
+	std::string preamble = npy_preamble(this->descr, this->shape(n_row), 64, this->data_offset);
+	memcpy(this->map, preamble.data(), preamble.length());
+	munmap(this->map, this->map_len);
+	this->n_row = n_row;
+	this->map_len = this->data_offset + this->item_size*this->n_row*this->n_col;
+	if (ftruncate(this->fd, this->map_len) < 0)
+	{
+		fprintf(stderr, "-- ERROR: can not resize %s to %lu bytes\n", this->filename.c_str(), this->map_len);
+		std::exit(EXIT_FAILURE);
+	}
+	void *ptr = mmap(NULL, this->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+	if (ptr == MAP_FAILED)
+	{
+		fprintf(stderr, "-- ERROR: can not map %s\n", this->filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	this->map = static_cast<uint8_t *>(ptr);
+}
+
+Npy_matrix::~Npy_matrix()
+{
+	munmap(this->map, this->map_len);
+	close(this->fd);
+}
+
+unsigned long int Npy_matrix::get_n_row(void) const
+{
+	return this->n_row;
+}
+
+unsigned long int Npy_matrix::get_n_col(void) const
+{
+	return this->n_col;
+}
+
+void *Npy_matrix::row(unsigned long int row_idx)
+{
+	return this->map + this->data_offset + this->item_size*this->n_col*row_idx;
+}
+
+void Npy_matrix::write_row(unsigned long int row_idx, const std::vector<unsigned int> &vec)
+{
+	unsigned long int n = vec.size();
+
+	if (n > this->n_col)
+	{
+		fprintf(stderr, "-- ERROR: row of %lu items does not fit in the %lu columns of %s\n", n, this->n_col, this->filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	/* samples past the end of a shorter vector are left to 0 */
+	switch (this->item_size)
+	{
+		case 1:
+		{
+			uint8_t *dst = static_cast<uint8_t *>(this->row(row_idx));
+			for (unsigned long int i = 0; i < n; ++i)
+			{
+				dst[i] = vec[i];
+			}
+			break;
+		}
+		case 2:
+		{
+			uint16_t *dst = static_cast<uint16_t *>(this->row(row_idx));
+			for (unsigned long int i = 0; i < n; ++i)
+			{
+				dst[i] = vec[i];
+			}
+			break;
+		}
+		case 4:
+		{
+			uint32_t *dst = static_cast<uint32_t *>(this->row(row_idx));
+			for (unsigned long int i = 0; i < n; ++i)
+			{
+				dst[i] = vec[i];
+			}
+			break;
+		}
+	}
+}
+
+Npy_reader::Npy_reader(std::string filename)
+{
+	this->filename = filename;
+	this->fd = open(filename.c_str(), O_RDONLY);
+	if (this->fd < 0)
+	{
+		fprintf(stderr, "-- ERROR: can not open %s\n", filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	off_t file_len = lseek(this->fd, 0, SEEK_END);
+	uint8_t prefix[12];
+	if (file_len < 12 || pread(this->fd, prefix, sizeof(prefix), 0) != sizeof(prefix)
+		|| memcmp(prefix, "\x93NUMPY", 6) != 0)
+	{
+		fprintf(stderr, "-- ERROR: %s is not a .npy file\n", filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	/* version 1 has a 16-bit header length, versions 2 and 3 a 32-bit one */
+	size_t header_len = (prefix[6] == 1) ? prefix[8] | (prefix[9] << 8)
+		: prefix[8] | (prefix[9] << 8) | (prefix[10] << 16) | (static_cast<size_t>(prefix[11]) << 24);
+	size_t header_offset = (prefix[6] == 1) ? 10 : 12;
+	std::string header(header_len, ' ');
+	if (pread(this->fd, &header[0], header_len, header_offset) != static_cast<ssize_t>(header_len))
+	{
+		fprintf(stderr, "-- ERROR: %s: truncated header\n", filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	this->parse_header(header);
+	this->data_offset = header_offset + header_len;
+	this->map_len = this->data_offset + this->item_size*this->n_row*this->n_col;
+	if (static_cast<size_t>(file_len) < this->map_len)
+	{
+		fprintf(stderr, "-- ERROR: %s: %lu bytes, %lu expected\n", filename.c_str(), static_cast<unsigned long int>(file_len),
+			static_cast<unsigned long int>(this->map_len));
+		std::exit(EXIT_FAILURE);
+	}
+	void *ptr = mmap(NULL, this->map_len, PROT_READ, MAP_SHARED, this->fd, 0);
+	if (ptr == MAP_FAILED)
+	{
+		fprintf(stderr, "-- ERROR: can not map %s\n", filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	this->map = static_cast<const uint8_t *>(ptr);
+	/* rows are read in order */
+	madvise(ptr, this->map_len, MADV_SEQUENTIAL);
+}
+
+Npy_reader::~Npy_reader()
+{
+	munmap(const_cast<uint8_t *>(this->map), this->map_len);
+	close(this->fd);
+}
+
+/* {'descr': '|u1', 'fortran_order': False, 'shape': (n_row, n_col), } */
+void Npy_reader::parse_header(std::string header)
+{
+	size_t descr_pos = header.find("'descr':");
+	size_t order_pos = header.find("'fortran_order':");
+	size_t shape_pos = header.find("'shape':");
+
+	if (descr_pos == std::string::npos || order_pos == std::string::npos || shape_pos == std::string::npos)
+	{
+		fprintf(stderr, "-- ERROR: %s: can not parse the header\n", this->filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	size_t first = header.find('\'', descr_pos + 8);
+	size_t last = header.find('\'', first + 1);
+	this->descr = header.substr(first + 1, last - first - 1);
+	this->item_size = strtoul(this->descr.c_str() + 2, NULL, 10);
+	if (header.compare(header.find_first_not_of(' ', order_pos + 16), 5, "False") != 0)
+	{
+		fprintf(stderr, "-- ERROR: %s: Fortran order is not supported\n", this->filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	const char *shape = header.c_str() + header.find('(', shape_pos) + 1;
+	char *end;
+	this->n_row = strtoul(shape, &end, 10);
+	this->n_col = 1;
+	while (*end == ',' || *end == ' ')
+	{
+		end++;
+	}
+	if (*end != ')')
+	{
+		this->n_col = strtoul(end, &end, 10);
+	}
+}
+
+std::string Npy_reader::get_descr(void) const
+{
+	return this->descr;
+}
+
+unsigned long int Npy_reader::get_n_row(void) const
+{
+	return this->n_row;
+}
+
+unsigned long int Npy_reader::get_n_col(void) const
+{
+	return this->n_col;
+}
+
+const void *Npy_reader::row(unsigned long int row_idx) const
+{
+	return this->map + this->data_offset + this->item_size*this->n_col*row_idx;
+}
+
+/* the pages of the rows [first_row, last_row) will not be read again */
+void Npy_reader::release(unsigned long int first_row, unsigned long int last_row) const
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t first = this->data_offset + this->item_size*this->n_col*first_row;
+	size_t last = this->data_offset + this->item_size*this->n_col*last_row;
+
+	/* whole pages only */
+	first = (first + page - 1)/page*page;
+	last = last/page*page;
+	if (first < last)
+	{
+		madvise(const_cast<uint8_t *>(this->map) + first, last - first, MADV_DONTNEED);
+	}
+}
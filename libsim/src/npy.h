@@ -38,5 +38,67 @@
 #include <vector>
 
 void save_npy(std::string filename, std::vector<double> vec);
+void save_npy(std::string filename, std::vector<double> vec, unsigned long int n_col);
+
+/* 2D .npy file (row major) memory-mapped for writing. The file is sized for
+   n_row x n_col unsigned integers of type descr ('|u1', '<u2' or '<u4') when created,
+   so rows can be written in place and the result loaded with
+   np.load(filename, mmap_mode='r') */
+class Npy_matrix
+{
+	private:
+		int fd;
+		uint8_t *map;
+		size_t map_len;
+		size_t data_offset;
+		unsigned long int n_row;
+		unsigned long int n_col;
+		unsigned int item_size;
+		bool is_1d;
+		std::string filename;
+		std::string descr;
+
+		std::string shape(unsigned long int n_row) const;
+		void create(std::string filename, std::string descr, std::string shape);
+
+	public:
+		Npy_matrix(std::string filename, std::string descr, unsigned long int n_row, unsigned long int n_col);
+		Npy_matrix(std::string filename, std::string descr, unsigned long int n_row); /* 1D, one item per row */
+		~Npy_matrix();
+		unsigned long int get_n_row(void) const;
+		unsigned long int get_n_col(void) const;
+		void *row(unsigned long int row_idx);
+		void write_row(unsigned long int row_idx, const std::vector<unsigned int> &vec);
+		void truncate(unsigned long int n_row);
+};
+
+/* .npy file (1D or 2D, C order) memory-mapped for reading, e.g. the traces
+   saved by a campaign. Rows are read in place; release() lets the kernel drop
+   the pages of the rows already processed, so that files larger than the
+   memory can be streamed */
+class Npy_reader
+{
+	private:
+		int fd;
+		const uint8_t *map;
+		size_t map_len;
+		size_t data_offset;
+		unsigned long int n_row;
+		unsigned long int n_col;
+		unsigned int item_size;
+		std::string filename;
+		std::string descr;
+
+		void parse_header(std::string header);
+
+	public:
+		Npy_reader(std::string filename);
+		~Npy_reader();
+		std::string get_descr(void) const;
+		unsigned long int get_n_row(void) const;
+		unsigned long int get_n_col(void) const;
+		const void *row(unsigned long int row_idx) const;
+		void release(unsigned long int first_row, unsigned long int last_row) const;
+};
 
 #endif
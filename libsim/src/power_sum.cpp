@@ -0,0 +1,375 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Welsch t-test on exact integer power sums
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include "power_sum.h"
+#include "utils.h"
+
+/* 65535*255^2 < 2^32 */
+#define MAX_PENDING 65535
+/* samples per block of update_batch(): s1 and s2 of a block take 16 kB */
+#define BLOCK_SAMPLE 2048
+/* sums of x and x^2 */
+#define N_POWER 2
+
+
+/* s1[i] += x[i], s2[i] += x[i]^2 */
+AVX2_CLONES
+static void add_powers(uint32_t *s1, uint32_t *s2, const uint8_t *x, unsigned int n)
+{
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		uint32_t v = x[i];
+		s1[i] += v;
+		s2[i] += v*v;
+	}
+}
+
+/* s1[i] += w*x[i], s2[i] += w*x[i]^2 */
+AVX2_CLONES
+static void add_weighted_powers(uint32_t *s1, uint32_t *s2, const uint8_t *x, unsigned int n, uint32_t w)
+{
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		uint32_t v = x[i];
+		s1[i] += w*v;
+		s2[i] += w*v*v;
+	}
+}
+
+
+Power_sum_ttest::Power_sum_ttest(unsigned int n_sample)
+{
+	this->n_sample = n_sample;
+	this->reset();
+}
+
+Power_sum_ttest::~Power_sum_ttest()
+{
+}
+
+void Power_sum_ttest::reset(void)
+{
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->n[cls] = 0;
+		this->n_pending[cls] = 0;
+		this->s1_32[cls].assign(this->n_sample, 0);
+		this->s2_32[cls].assign(this->n_sample, 0);
+		this->sums[cls].assign(N_POWER*this->n_sample, 0);
+	}
+	this->buffer.resize(this->n_sample);
+}
+
+void Power_sum_ttest::flush(unsigned int cls)
+{
+	uint64_t *sum1 = this->sums[cls].data();
+	uint64_t *sum2 = sum1 + this->n_sample;
+
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		sum1[i] += this->s1_32[cls][i];
+		sum2[i] += this->s2_32[cls][i];
+		this->s1_32[cls][i] = 0;
+		this->s2_32[cls][i] = 0;
+	}
+	this->n_pending[cls] = 0;
+}
+
+/* append a sample that had the same value in all the traces seen so far */
+void Power_sum_ttest::add_constant_sample(unsigned int value)
+{
+	std::vector<uint64_t> sums[2];
+
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->flush(cls);
+		sums[cls].reserve(N_POWER*(this->n_sample + 1));
+		uint64_t power = 1;
+		for (unsigned int k = 0; k < N_POWER; ++k)
+		{
+			power *= value;
+			auto first = this->sums[cls].begin() + k*this->n_sample;
+			sums[cls].insert(sums[cls].end(), first, first + this->n_sample);
+			sums[cls].push_back(this->n[cls]*power);
+		}
+		this->sums[cls].swap(sums[cls]);
+		this->s1_32[cls].push_back(0);
+		this->s2_32[cls].push_back(0);
+	}
+	this->n_sample++;
+	this->buffer.resize(this->n_sample);
+}
+
+void Power_sum_ttest::update(unsigned int cls, const std::vector<unsigned int> &vec)
+{
+	uint8_t *x = this->buffer.data();
+
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		x[i] = vec[i];
+	}
+	this->update_batch(cls, x, 1, nullptr, nullptr);
+}
+
+/* adds the samples [i_first, i_last) of the n_trace rows of batch */
+void Power_sum_ttest::add_batch(unsigned int cls, const uint8_t *batch, unsigned int n_trace, const unsigned int *weight,
+	unsigned int i_first, unsigned int i_last)
+{
+	for (unsigned int i0 = i_first; i0 < i_last; i0 += BLOCK_SAMPLE)
+	{
+		unsigned int i1 = (i0 + BLOCK_SAMPLE < i_last) ? i0 + BLOCK_SAMPLE : i_last;
+		for (unsigned int t = 0; t < n_trace; ++t)
+		{
+			const uint8_t *x = batch + static_cast<unsigned long int>(t)*this->n_sample;
+			uint32_t w = (weight != nullptr) ? weight[t] : 1;
+			if (w == 1)
+			{
+				add_powers(this->s1_32[cls].data() + i0, this->s2_32[cls].data() + i0, x + i0, i1 - i0);
+			}
+			else
+			{
+				add_weighted_powers(this->s1_32[cls].data() + i0, this->s2_32[cls].data() + i0, x + i0, i1 - i0, w);
+			}
+		}
+	}
+}
+
+/* The traces are the rows of the (n_trace x n_sample) matrix batch, row t
+   standing for weight[t] identical traces (1 if weight is nullptr). The sums
+   are updated by blocks of samples with all the traces of the batch, so that
+   the sums of a block stay in cache. With a pool, each thread updates its
+   slice of the samples */
+void Power_sum_ttest::update_batch(unsigned int cls, const uint8_t *batch, unsigned int n_trace, const unsigned int *weight,
+	Sample_pool *pool)
+{
+	while (n_trace > 0)
+	{
+		/* rows whose weights fit in the 32-bit sums */
+		unsigned int n_chunk = 0;
+		unsigned int w_chunk = 0;
+		for (; n_chunk < n_trace; ++n_chunk)
+		{
+			unsigned int w = (weight != nullptr) ? weight[n_chunk] : 1;
+			if (w > MAX_PENDING - this->n_pending[cls] - w_chunk)
+			{
+				break;
+			}
+			w_chunk += w;
+		}
+		if (n_chunk == 0 && this->n_pending[cls] == 0)
+		{
+			fprintf(stderr, "-- ERROR: trace weight %u exceeds %u\n", weight[0], MAX_PENDING);
+			std::exit(EXIT_FAILURE);
+		}
+		if (pool != nullptr)
+		{
+			pool->run(this->n_sample, [&](unsigned int i0, unsigned int i1) { this->add_batch(cls, batch, n_chunk, weight, i0, i1); });
+		}
+		else
+		{
+			this->add_batch(cls, batch, n_chunk, weight, 0, this->n_sample);
+		}
+		this->n[cls] += w_chunk;
+		this->n_pending[cls] += w_chunk;
+		if (this->n_pending[cls] == MAX_PENDING || n_chunk < n_trace)
+		{
+			this->flush(cls);
+		}
+		batch += static_cast<unsigned long int>(n_chunk)*this->n_sample;
+		weight = (weight != nullptr) ? weight + n_chunk : nullptr;
+		n_trace -= n_chunk;
+	}
+}
+
+void Power_sum_ttest::update1(const std::vector<unsigned int> &vec)
+{
+	this->update(0, vec);
+}
+
+void Power_sum_ttest::update2(const std::vector<unsigned int> &vec)
+{
+	this->update(1, vec);
+}
+
+void Power_sum_ttest::update1_batch(const uint8_t *batch, unsigned int n_trace, const unsigned int *weight, Sample_pool *pool)
+{
+	this->update_batch(0, batch, n_trace, weight, pool);
+}
+
+void Power_sum_ttest::update2_batch(const uint8_t *batch, unsigned int n_trace, const unsigned int *weight, Sample_pool *pool)
+{
+	this->update_batch(1, batch, n_trace, weight, pool);
+}
+
+/* back to the full trace: sample k goes to remap[k], the other samples had
+   the value constant_value[i] in every trace */
+void Power_sum_ttest::expand(const std::vector<unsigned int> &remap, const std::vector<unsigned int> &constant_value)
+{
+	unsigned int n_full = constant_value.size();
+
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->flush(cls);
+		std::vector<uint64_t> sums(N_POWER*n_full);
+		for (unsigned int i = 0; i < n_full; ++i)
+		{
+			uint64_t power = 1;
+			for (unsigned int k = 0; k < N_POWER; ++k)
+			{
+				power *= constant_value[i];
+				sums[k*n_full + i] = this->n[cls]*power;
+			}
+		}
+		for (unsigned int k = 0; k < N_POWER; ++k)
+		{
+			for (unsigned int j = 0; j < this->n_sample; ++j)
+			{
+				sums[k*n_full + remap[j]] = this->sums[cls][k*this->n_sample + j];
+			}
+		}
+		this->sums[cls].swap(sums);
+		this->s1_32[cls].assign(n_full, 0);
+		this->s2_32[cls].assign(n_full, 0);
+	}
+	this->n_sample = n_full;
+	this->buffer.resize(n_full);
+}
+
+/* sums are exact, so merging is just adding them */
+void Power_sum_ttest::merge(const Power_sum_ttest &other)
+{
+	if (other.n_sample != this->n_sample)
+	{
+		fprintf(stderr, "-- ERROR: can not merge power sums of %u and %u samples\n", this->n_sample, other.n_sample);
+		std::exit(EXIT_FAILURE);
+	}
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		uint64_t *sum1 = this->sums[cls].data();
+		uint64_t *sum2 = sum1 + this->n_sample;
+		for (unsigned int i = 0; i < this->sums[cls].size(); ++i)
+		{
+			this->sums[cls][i] += other.sums[cls][i];
+		}
+		/* pending 32-bit sums of the other test */
+		for (unsigned int i = 0; i < this->n_sample; ++i)
+		{
+			sum1[i] += other.s1_32[cls][i];
+			sum2[i] += other.s2_32[cls][i];
+		}
+		this->n[cls] += other.n[cls];
+	}
+}
+
+void Power_sum_ttest::save(State_writer &writer)
+{
+	writer.write_tag("Power_sum_ttest");
+	writer.write_u64(this->n_sample);
+	writer.write_u64(N_POWER);
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->flush(cls);
+		writer.write_u64(this->n[cls]);
+		writer.write(this->sums[cls]);
+	}
+}
+
+void Power_sum_ttest::load(State_reader &reader)
+{
+	reader.read_tag("Power_sum_ttest");
+	this->n_sample = reader.read_u64();
+	if (reader.read_u64() != N_POWER)
+	{
+		fprintf(stderr, "-- ERROR: %s: power sums beyond x^%u are not supported\n", reader.get_filename().c_str(), N_POWER);
+		std::exit(EXIT_FAILURE);
+	}
+	this->reset();
+	for (unsigned int cls = 0; cls < 2; ++cls)
+	{
+		this->n[cls] = reader.read_u64();
+		reader.read(this->sums[cls]);
+		if (this->sums[cls].size() != static_cast<unsigned long int>(N_POWER)*this->n_sample)
+		{
+			fprintf(stderr, "-- ERROR: %s: inconsistent power sums\n", reader.get_filename().c_str());
+			std::exit(EXIT_FAILURE);
+		}
+	}
+}
+
+unsigned long int Power_sum_ttest::get_count(unsigned int cls) const
+{
+	return this->n[cls];
+}
+
+/* sum of x^k (k = 1 or 2) of sample i */
+uint64_t Power_sum_ttest::get_power_sum(unsigned int cls, unsigned int k, unsigned int i)
+{
+	this->flush(cls);
+	return this->sums[cls][(k - 1)*this->n_sample + i];
+}
+
+/* n(n - 1)var = n*sum(x^2) - sum(x)^2 is computed exactly on 128 bits */
+std::vector<double> Power_sum_ttest::t_test(void)
+{
+	std::vector<double> t;
+	double mean[2];
+	double var[2];
+
+	this->flush(0);
+	this->flush(1);
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		for (unsigned int cls = 0; cls < 2; ++cls)
+		{
+			unsigned __int128 s1 = this->sums[cls][i];
+			unsigned __int128 s2 = this->sums[cls][this->n_sample + i];
+			unsigned __int128 cnt = this->n[cls];
+			mean[cls] = static_cast<double>(this->sums[cls][i])/this->n[cls];
+			var[cls] = static_cast<double>(cnt*s2 - s1*s1)/(static_cast<double>(this->n[cls])*(this->n[cls] - 1));
+		}
+		double term = sqrt(var[0]/this->n[0] + var[1]/this->n[1]);
+		if (term == 0.0)
+		{
+			t.push_back(0.0);
+		}
+		else
+		{
+			t.push_back((mean[0] - mean[1])/term);
+		}
+	}
+	return t;
+}
@@ -0,0 +1,89 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Welsch t-test on exact integer power sums
+ *
+ ******************************************************************************/
+
+#ifndef __POWER_SUM_H__
+#define __POWER_SUM_H__
+
+#include <cstdint>
+#include <vector>
+#include "state_file.h"
+#include "sample_pool.h"
+
+/* Samples are 8-bit integers (Hamming weights or ADC codes). For each sample
+   and class, the sums of x and x^2 are kept in 64-bit integers, so the
+   accumulation is exact and independent of the order of the traces. x and x^2
+   are first accumulated in 32-bit counters (with AVX2 when available) and
+   flushed to the 64-bit sums before they can overflow. Means and variances
+   are only computed by t_test(). Batches of traces (update1_batch(),
+   update2_batch()) are accumulated by blocks of samples, split among the
+   threads of a Sample_pool if given. A row of a batch can stand for several
+   identical traces (weight). Higher orders are left to Moment_ttest: the sum
+   of x^5 would wrap 64 bits after about 1.7e7 traces */
+class Power_sum_ttest
+{
+	private:
+		unsigned int n_sample;
+		unsigned long int n[2];
+		unsigned int n_pending[2];
+		std::vector<uint32_t> s1_32[2];
+		std::vector<uint32_t> s2_32[2];
+		std::vector<uint64_t> sums[2];     /* sum of x^k (k = 1, 2) of sample i at (k - 1)*n_sample + i */
+		std::vector<uint8_t> buffer;
+
+		void update(unsigned int cls, const std::vector<unsigned int> &vec);
+		void add_batch(unsigned int cls, const uint8_t *batch, unsigned int n_trace, const unsigned int *weight,
+			unsigned int i_first, unsigned int i_last);
+		void update_batch(unsigned int cls, const uint8_t *batch, unsigned int n_trace, const unsigned int *weight,
+			Sample_pool *pool);
+		void flush(unsigned int cls);
+
+	public:
+		Power_sum_ttest(unsigned int n_sample);
+		~Power_sum_ttest();
+		void reset(void);
+		void add_constant_sample(unsigned int value);
+		void update1(const std::vector<unsigned int> &vec);
+		void update2(const std::vector<unsigned int> &vec);
+		void update1_batch(const uint8_t *batch, unsigned int n_trace, const unsigned int *weight = nullptr,
+			Sample_pool *pool = nullptr);
+		void update2_batch(const uint8_t *batch, unsigned int n_trace, const unsigned int *weight = nullptr,
+			Sample_pool *pool = nullptr);
+		void expand(const std::vector<unsigned int> &remap, const std::vector<unsigned int> &constant_value);
+		void merge(const Power_sum_ttest &other);
+		void save(State_writer &writer);
+		void load(State_reader &reader);
+		unsigned long int get_count(unsigned int cls) const;
+		uint64_t get_power_sum(unsigned int cls, unsigned int k, unsigned int i);
+		std::vector<double> t_test(void);
+};
+
+#endif
@@ -52,12 +52,17 @@ Register::~Register()
 
 void Register::write(uint32_t val)
 {
-	unsigned int pwr = bit_count(this->value ^ val);
+	uint32_t leakage = this->value ^ val;
 	this->value = val;
-	this->tracer_ptr->update(pwr);
+	this->tracer_ptr->update(leakage, this->name.c_str());
 	REG_LOG_TRACE("%s = %08x\n", this->name.c_str(), val);
 }
 
+void Register::write_notrace(uint32_t val)
+{
+	this->value = val;
+}
+
 void Register::set_name(std::string name)
 {
 	this->name = name;
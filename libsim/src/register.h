@@ -49,6 +49,7 @@ class Register
 		~Register();
 		void set_name(std::string name);
 		void write(uint32_t val);
+		void write_notrace(uint32_t val);
 		uint32_t read(void);
 		void bind_tracer(Tracer *ptr);
 };
@@ -0,0 +1,202 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Elimination of constant samples
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include "sample_filter.h"
+
+
+Sample_filter::Sample_filter(unsigned int n_sample)
+{
+	this->n_sample = n_sample;
+	this->n_learnt = 0;
+	this->frozen = false;
+	this->constant_value.resize(n_sample, 0);
+	this->is_constant.resize(n_sample, true);
+}
+
+Sample_filter::~Sample_filter()
+{
+	/* intentionally empty */
+}
+
+/* the first learnt trace gives the candidate constants */
+void Sample_filter::learn(const std::vector<unsigned int> &trace)
+{
+	if (this->n_learnt == 0)
+	{
+		for (unsigned int i = 0; i < this->n_sample; ++i)
+		{
+			this->constant_value[i] = trace[i];
+		}
+	}
+	else
+	{
+		for (unsigned int i = 0; i < this->n_sample; ++i)
+		{
+			if (trace[i] != this->constant_value[i])
+			{
+				this->is_constant[i] = false;
+			}
+		}
+	}
+	this->n_learnt++;
+}
+
+/* end of warm-up. Without any learnt trace all samples are kept */
+void Sample_filter::freeze(void)
+{
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		if (this->is_constant[i] && this->n_learnt > 0)
+		{
+			this->dropped.push_back(i);
+		}
+		else
+		{
+			this->remap.push_back(i);
+		}
+	}
+	this->frozen = true;
+}
+
+bool Sample_filter::is_frozen(void) const
+{
+	return this->frozen;
+}
+
+unsigned int Sample_filter::get_n_sample(void) const
+{
+	return this->n_sample;
+}
+
+unsigned int Sample_filter::get_n_kept(void) const
+{
+	return this->remap.size();
+}
+
+unsigned int Sample_filter::get_constant_value(unsigned int kept_idx) const
+{
+	return this->constant_value[this->remap[kept_idx]];
+}
+
+const std::vector<unsigned int> &Sample_filter::get_remap(void) const
+{
+	return this->remap;
+}
+
+/* value of each sample of the full trace during the warm-up */
+const std::vector<unsigned int> &Sample_filter::get_constant_values(void) const
+{
+	return this->constant_value;
+}
+
+/* Returns the number of dropped samples that changed in this trace. They are
+   appended to the kept samples, so the caller must add them to its
+   accumulators (see get_constant_value()) before using out */
+unsigned int Sample_filter::compact(const std::vector<unsigned int> &trace, std::vector<unsigned int> &out)
+{
+	unsigned int n_readmitted = 0;
+
+	for (unsigned int k = 0; k < this->dropped.size(); )
+	{
+		unsigned int i = this->dropped[k];
+		if (trace[i] != this->constant_value[i])
+		{
+			this->remap.push_back(i);
+			this->dropped.erase(this->dropped.begin() + k);
+			n_readmitted++;
+		}
+		else
+		{
+			++k;
+		}
+	}
+
+	unsigned int n_kept = this->remap.size();
+	out.resize(n_kept);
+	for (unsigned int k = 0; k < n_kept; ++k)
+	{
+		out[k] = trace[this->remap[k]];
+	}
+	return n_readmitted;
+}
+
+/* back to the full trace length, dropped samples get 0 */
+std::vector<double> Sample_filter::expand(const std::vector<double> &vec) const
+{
+	std::vector<double> full(this->n_sample, 0.0);
+
+	for (unsigned int k = 0; k < this->remap.size(); ++k)
+	{
+		full[this->remap[k]] = vec[k];
+	}
+	return full;
+}
+
+void Sample_filter::save(State_writer &writer) const
+{
+	writer.write_tag("Sample_filter");
+	writer.write_u64(this->n_sample);
+	writer.write_u64(this->n_learnt);
+	writer.write_u64(this->frozen);
+	writer.write(std::vector<uint32_t>(this->constant_value.begin(), this->constant_value.end()));
+	writer.write(std::vector<uint32_t>(this->is_constant.begin(), this->is_constant.end()));
+	writer.write(std::vector<uint32_t>(this->remap.begin(), this->remap.end()));
+	writer.write(std::vector<uint32_t>(this->dropped.begin(), this->dropped.end()));
+}
+
+void Sample_filter::load(State_reader &reader)
+{
+	std::vector<uint32_t> vec;
+
+	reader.read_tag("Sample_filter");
+	this->n_sample = reader.read_u64();
+	this->n_learnt = reader.read_u64();
+	this->frozen = reader.read_u64();
+	reader.read(vec);
+	this->constant_value.assign(vec.begin(), vec.end());
+	reader.read(vec);
+	this->is_constant.assign(vec.begin(), vec.end());
+	reader.read(vec);
+	this->remap.assign(vec.begin(), vec.end());
+	reader.read(vec);
+	this->dropped.assign(vec.begin(), vec.end());
+	if (this->constant_value.size() != this->n_sample || this->is_constant.size() != this->n_sample
+		|| this->remap.size() + this->dropped.size() != (this->frozen ? this->n_sample : 0))
+	{
+		fprintf(stderr, "-- ERROR: %s: inconsistent sample filter\n", reader.get_filename().c_str());
+		std::exit(EXIT_FAILURE);
+	}
+}
@@ -0,0 +1,140 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Thread pool partitioning the samples of the accumulators
+ *
+ ******************************************************************************/
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "sample_pool.h"
+
+/* slices start on multiples of SLICE_ALIGN samples, so that two threads do
+   not write to the same cache line */
+#define SLICE_ALIGN 64
+
+
+Sample_pool::Sample_pool(unsigned int n_thread)
+{
+	this->n_thread = (n_thread < 1) ? 1 : n_thread;
+	this->task = nullptr;
+	this->n_sample = 0;
+	this->generation = 0;
+	this->n_running = 0;
+	this->stopping = false;
+	for (unsigned int k = 1; k < this->n_thread; ++k)
+	{
+		this->threads.push_back(std::thread(&Sample_pool::work, this, k));
+	}
+}
+
+Sample_pool::~Sample_pool()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->start_cond.notify_all();
+	for (auto &thread : this->threads)
+	{
+		thread.join();
+	}
+}
+
+unsigned int Sample_pool::get_n_thread(void) const
+{
+	return this->n_thread;
+}
+
+void Sample_pool::get_slice(unsigned int k, unsigned int n_sample, unsigned int &i0, unsigned int &i1) const
+{
+	unsigned long int n_block = (static_cast<unsigned long int>(n_sample) + SLICE_ALIGN - 1)/SLICE_ALIGN;
+	unsigned long int first = n_block*k/this->n_thread*SLICE_ALIGN;
+	unsigned long int last = n_block*(k + 1)/this->n_thread*SLICE_ALIGN;
+
+	i0 = (first < n_sample) ? first : n_sample;
+	i1 = (last < n_sample) ? last : n_sample;
+}
+
+void Sample_pool::work(unsigned int k)
+{
+	unsigned long int seen = 0;
+
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->start_cond.wait(lock, [&] { return this->stopping || this->generation != seen; });
+		if (this->stopping)
+		{
+			return;
+		}
+		seen = this->generation;
+		const std::function<void(unsigned int, unsigned int)> *task = this->task;
+		unsigned int i0, i1;
+		this->get_slice(k, this->n_sample, i0, i1);
+		lock.unlock();
+		if (i0 < i1)
+		{
+			(*task)(i0, i1);
+		}
+		lock.lock();
+		if (--this->n_running == 0)
+		{
+			this->done_cond.notify_one();
+		}
+	}
+}
+
+void Sample_pool::run(unsigned int n_sample, const std::function<void(unsigned int i0, unsigned int i1)> &task)
+{
+	unsigned int i0, i1;
+
+	if (this->n_thread == 1)
+	{
+		task(0, n_sample);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->task = &task;
+		this->n_sample = n_sample;
+		this->n_running = this->n_thread - 1;
+		this->generation++;
+	}
+	this->start_cond.notify_all();
+	this->get_slice(0, n_sample, i0, i1);
+	if (i0 < i1)
+	{
+		task(i0, i1);
+	}
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->done_cond.wait(lock, [&] { return this->n_running == 0; });
+}
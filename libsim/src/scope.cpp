@@ -0,0 +1,197 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Measurement model (noise, bandwidth and sampling of an oscilloscope)
+ *
+ ******************************************************************************/
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include "scope.h"
+
+#define ADC_OFFSET 64     /* ADC code of a null Hamming weight */
+#define ADC_MAX 255
+#define NOISE_BLOCK 256   /* random numbers drawn at once, one per pair of samples */
+
+/* SplitMix64 finalizer */
+static inline uint64_t mix64(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+Scope::Scope(Options &options)
+{
+	this->noise_sigma = options.noise_sigma;
+	this->fir_taps = options.fir_taps;
+	this->decimation = options.decimation;
+	this->adc_gain = options.adc_gain;
+	this->seed = 0;
+}
+
+Scope::~Scope()
+{
+	/* intentionally empty */
+}
+
+bool Scope::is_enabled(void) const
+{
+	return (this->noise_sigma > 0.0) || (this->fir_taps.size() > 0) || (this->decimation > 1);
+}
+
+void Scope::set_seed(uint64_t seed)
+{
+	this->seed = seed;
+}
+
+uint64_t Scope::get_seed(void) const
+{
+	return this->seed;
+}
+
+/* Box-Muller transform on two 32-bit uniforms drawn from one 64-bit counter
+   based random number, i.e. one random number for two samples. The random
+   numbers of a block do not depend on each other and are drawn by a loop of
+   integer operations, which the compiler vectorizes when the target has 64-bit
+   vector multiplies (e.g. AVX-512). The transform keeps the scalar libm calls,
+   whose results do not depend on the vector width, so that the noise of a
+   trace number stays the same across builds and checkpoints */
+void Scope::add_noise(uint64_t trace_number)
+{
+	const double two_pi = 2.0*M_PI;
+	const double scale = 1.0/4294967296.0;
+	uint64_t key = mix64(this->seed + trace_number*0x9e3779b97f4a7c15ULL);
+	unsigned long int n = this->analog.size();
+	uint64_t r[NOISE_BLOCK];
+
+	for (unsigned long int i0 = 0; i0 < n; i0 += 2*NOISE_BLOCK)
+	{
+		unsigned long int n_pair = (n - i0 + 1)/2;
+		n_pair = (n_pair < NOISE_BLOCK) ? n_pair : NOISE_BLOCK;
+		for (unsigned long int k = 0; k < n_pair; ++k)
+		{
+			r[k] = mix64(key + (i0 + 2*k)*0x9e3779b97f4a7c15ULL);
+		}
+		for (unsigned long int k = 0; k < n_pair; ++k)
+		{
+			unsigned long int i = i0 + 2*k;
+			double u1 = ((r[k] >> 32) + 0.5)*scale;
+			double u2 = ((r[k] & 0xffffffff) + 0.5)*scale;
+			double rad = this->noise_sigma*sqrt(-2.0*log(u1));
+			this->analog[i] += rad*cos(two_pi*u2);
+			if (i + 1 < n)
+			{
+				this->analog[i + 1] += rad*sin(two_pi*u2);
+			}
+		}
+	}
+}
+
+/* The (causal) filter is only evaluated at the decimated sample positions
+   j*decimation. Row p of the polyphase matrix holds the samples
+   m*decimation + p, so that the input of tap k is a contiguous row for all
+   the outputs: the loop over the outputs is the inner one and vectorizes.
+   Each output still adds its taps in increasing order, i.e. the result is
+   the same as the direct form */
+void Scope::filter(void)
+{
+	unsigned long int n = this->analog.size();
+	unsigned long int n_tap = this->fir_taps.size();
+	unsigned long int n_out = (n + this->decimation - 1)/this->decimation;
+
+	this->filtered.assign(n_out, 0.0);
+	if (n_tap == 0)
+	{
+		for (unsigned long int j = 0; j < n_out; ++j)
+		{
+			this->filtered[j] = this->analog[j*this->decimation];
+		}
+		return;
+	}
+	this->phases.assign(this->decimation*n_out, 0.0);
+	for (unsigned long int i = 0; i < n; ++i)
+	{
+		this->phases[(i % this->decimation)*n_out + i/this->decimation] = this->analog[i];
+	}
+	for (unsigned long int k = 0; k < n_tap; ++k)
+	{
+		/* sample j*decimation - k is sample (j - q)*decimation + p of row p, and
+		   exists for j >= q */
+		unsigned long int q = (k + this->decimation - 1)/this->decimation;
+		unsigned long int p = q*this->decimation - k;
+		if (q >= n_out)
+		{
+			break;
+		}
+		const double tap = this->fir_taps[k];
+		const double *__restrict x = this->phases.data() + p*n_out;
+		double *__restrict y = this->filtered.data() + q;
+		for (unsigned long int m = 0; m < n_out - q; ++m)
+		{
+			y[m] += tap*x[m];
+		}
+	}
+}
+
+void Scope::apply(std::vector<unsigned int> &trace, uint64_t trace_number)
+{
+	if (!this->is_enabled())
+	{
+		return;
+	}
+
+	unsigned long int n = trace.size();
+	this->analog.resize(n);
+	for (unsigned long int i = 0; i < n; ++i)
+	{
+		this->analog[i] = trace[i];
+	}
+	if (this->noise_sigma > 0.0)
+	{
+		this->add_noise(trace_number);
+	}
+	this->filter();
+
+	unsigned long int n_out = this->filtered.size();
+	for (unsigned long int j = 0; j < n_out; ++j)
+	{
+		long int code = lround(this->adc_gain*this->filtered[j]) + ADC_OFFSET;
+		if (code < 0)
+		{
+			code = 0;
+		}
+		else if (code > ADC_MAX)
+		{
+			code = ADC_MAX;
+		}
+		trace[j] = code;
+	}
+	trace.resize(n_out);
+}
@@ -33,11 +33,13 @@
 
 #include <cstdio>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 #include <random>
 #include <iostream>
 #include <fstream>
 #include <unistd.h>
+#include <getopt.h>
 #include "t_test.h"
 #include "npy.h"
 #include "sim_sec_algo.h"
@@ -50,9 +52,17 @@ int main(int argc, char *argv[])
 {
 	Options options = default_options;
 	bool do_test = false;
+	std::vector<unsigned int> pipeline;
 	int c;
+	static const struct option long_options[] =
+	{
+		{"checkpoint", required_argument, NULL, 'C'},
+		{"resume", no_argument, NULL, 'R'},
+		{"extend", required_argument, NULL, 'E'},
+		{NULL, 0, NULL, 0}
+	};
 
-	while ((c = getopt(argc, argv, "sto:n:i:vgp")) != -1)
+	while ((c = getopt_long(argc, argv, "sto:n:i:vgpN:F:D:G:bw:ad:W:P:S:m:C:RE:c:e:KHIT:rxA:j:z:J:L:", long_options, NULL)) != -1)
 	{
 		switch (c)
 		{
@@ -81,24 +91,245 @@ int main(int argc, char *argv[])
 			case 'p':
 				options.with_pipeline_leakage = true;
 				break;
+			case 'N':
+				options.noise_sigma = strtod(optarg, NULL);
+				break;
+			case 'F':
+				options.fir_taps = parse_double_list(optarg);
+				break;
+			case 'D':
+				options.decimation = strtoul(optarg, NULL, 0);
+				break;
+			case 'G':
+				options.adc_gain = strtod(optarg, NULL);
+				break;
+			case 'b':
+				options.with_bit_leakage = true;
+				break;
+			case 'w':
+				options.n_warmup = strtoul(optarg, NULL, 0);
+				break;
+			case 'a':
+				options.with_alignment = true;
+				break;
+			case 'd':
+				options.t_test_order = strtoul(optarg, NULL, 0);
+				break;
+			case 'W':
+				options.bivariate_window = strtoul(optarg, NULL, 0);
+				break;
+			case 'P':
+				options.poi = parse_uint_list(optarg);
+				break;
+			case 'S':
+				options.state_filename = optarg;
+				break;
+			case 'm':
+				options.merge_filenames.push_back(optarg);
+				break;
+			case 'C':
+				options.checkpoint_interval = strtoul(optarg, NULL, 0);
+				break;
+			case 'R':
+				options.resume = true;
+				break;
+			case 'E':
+				options.n_extend = strtoul(optarg, NULL, 0);
+				break;
+			case 'c':
+				options.convergence_ppd = strtoul(optarg, NULL, 0);
+				break;
+			case 'e':
+				options.stop_threshold = strtod(optarg, NULL);
+				break;
+			case 'K':
+				options.with_cpa = true;
+				break;
+			case 'H':
+				options.with_histogram = true;
+				break;
+			case 'I':
+				options.with_information = true;
+				break;
+			case 'T':
+				options.template_poi = parse_uint_list(optarg);
+				break;
+			case 'r':
+				options.with_hotspots = true;
+				break;
+			case 'x':
+				options.with_control = true;
+				break;
+			case 'A':
+				if (strcmp(optarg, "value") == 0)
+				{
+					options.anova_classes = ANOVA_VALUE;
+				}
+				else if (strcmp(optarg, "hw") == 0)
+				{
+					options.anova_classes = ANOVA_HW;
+				}
+				else
+				{
+					fprintf(stderr, "ERROR: -A <classes> must be 'value' or 'hw'\n");
+					std::exit(EXIT_FAILURE);
+				}
+				break;
+			case 'j':
+				options.n_thread = strtoul(optarg, NULL, 0);
+				break;
+			case 'z':
+				options.sparse_buckets = strtoul(optarg, NULL, 0);
+				break;
+			case 'J':
+				options.n_worker = strtoul(optarg, NULL, 0);
+				break;
+			case 'L':
+				pipeline = parse_uint_list(optarg);
+				if (pipeline.size() != 2 || pipeline[0] < 1 || pipeline[1] < 1)
+				{
+					fprintf(stderr, "ERROR: -L <n_producer>,<n_consumer> requires two thread counts of at least 1\n");
+					std::exit(EXIT_FAILURE);
+				}
+				options.n_producer = pipeline[0];
+				options.n_consumer = pipeline[1];
+				break;
 			default:
-                fprintf(stderr, "%s -v | [-i <trace_index_file>] [-s] [-o <filename>] [-t | -n <n_measure]> [-g]\n", argv[0]);
+                fprintf(stderr, "%s -v | [-i <trace_index_file>] [-s] [-o <filename>] [-t | -n <n_measure]> [-g] [-N <sigma>] [-F <taps>] [-D <factor>] [-G <gain>] [-b] [-w <n_warmup>] [-a] [-d <order>] [-W <window> | -P <poi>] [-S <state_file>] [-m <state_file>]... [-C <n>] [-R | -E <n>] [-c <points>] [-e <threshold>] [-K] [-H] [-I] [-T <poi>] [-r] [-x] [-A <value | hw>] [-j <n_thread>] [-z <n_bucket>] [-J <n_worker> | -L <n_producer>,<n_consumer>]\n", argv[0]);
                 fprintf(stderr, "\t-i: generate power trace index\n");
-				fprintf(stderr, "\t-s: save traces\n");
+				fprintf(stderr, "\t-s: save traces, labels and inputs as .npy matrices\n");
 				fprintf(stderr, "\t-t: test for correctness with test vectors\n");
 				fprintf(stderr, "\t-o: name of .npy file. Default to 't_test.npy'\n");
 				fprintf(stderr, "\t-n: number of measurements\n");
 				fprintf(stderr, "\t-v: print version number and exit\n");
 				fprintf(stderr, "\t-g: wait for gdb connection on port 50007\n");
 				fprintf(stderr, "\t-p: include leakage from pipeline registers A and B\n"); /* TODO: negate flag usage after functionality has been verified */
+				fprintf(stderr, "\t-N: add gaussian measurement noise of given std deviation (Hamming weight units)\n");
+				fprintf(stderr, "\t-F: filter traces with the comma separated FIR taps (scope bandwidth)\n");
+				fprintf(stderr, "\t-D: decimate traces by the given factor\n");
+				fprintf(stderr, "\t-G: ADC gain in codes per Hamming weight unit when -N, -F or -D is used. Default to 4\n");
+				fprintf(stderr, "\t-b: also run bit-level t-test and chi-square test on bit transitions\n");
+				fprintf(stderr, "\t-w: number of warm-up measurements used to skip constant samples. Default to 64, 0 disables\n");
+				fprintf(stderr, "\t-a: align samples on the executed instructions (input dependent control flow)\n");
+				fprintf(stderr, "\t-d: also run the univariate t-test at orders 2 to <order>. Default to 1\n");
+				fprintf(stderr, "\t-W: bivariate t-test on all sample pairs at most <window> samples apart\n");
+				fprintf(stderr, "\t-P: bivariate t-test on all pairs of the comma separated sample indices\n");
+				fprintf(stderr, "\t-S: save the state of the statistics to <state_file> so that it can be merged later\n");
+				fprintf(stderr, "\t-m: merge the state saved by another run with the same options (can be repeated)\n");
+				fprintf(stderr, "\t-C, --checkpoint: save a checkpoint every <n> measurements and at the end of the campaign\n");
+				fprintf(stderr, "\t-R, --resume: continue the campaign from its last checkpoint\n");
+				fprintf(stderr, "\t-E, --extend: add <n> measurements to the campaign of the last checkpoint\n");
+				fprintf(stderr, "\t-c: save max |t| at <points> log-spaced measurement counts per decade\n");
+				fprintf(stderr, "\t-e: stop when max |t| exceeds <threshold> (e.g. 4.5) at two consecutive points of -c (10 per decade by default)\n");
+				fprintf(stderr, "\t-K: correlation power analysis of the random input traces with the leakage model of the implementation\n");
+				fprintf(stderr, "\t-H: also run the chi-square test on the histograms of the samples (any order, -log10 p-values)\n");
+				fprintf(stderr, "\t-I: SNR and mutual information (bits) of the samples with the intermediate of the implementation\n");
+				fprintf(stderr, "\t-T: build templates (class means, pooled covariance) of the intermediate of the implementation on the comma separated sample indices\n");
+				fprintf(stderr, "\t-r: rank the instructions and source registers by max |t| (text and JSON hotspot report)\n");
+				fprintf(stderr, "\t-x: also run the control tests: fixed-vs-fixed with a second fixed input and random-vs-random\n");
+				fprintf(stderr, "\t-A: ANOVA F-test of the random traces partitioned by the value or the Hamming weight of the intermediate of the implementation\n");
+				fprintf(stderr, "\t-j: update the t-tests and histograms with <n_thread> threads, each owning a slice of the samples. Default to 1\n");
+				fprintf(stderr, "\t-z: also write the sparse t-tests: max |t| and the samples over the threshold of -e (4.5 by default) with their pc and source, and a min/max envelope of <n_bucket> buckets\n");
+				fprintf(stderr, "\t-J: simulate with <n_worker> threads, each with its own cpu, inputs and statistics merged at the end (full traces, no warm-up). Default to 1\n");
+				fprintf(stderr, "\t-L: pipeline of <n_producer> simulation threads feeding <n_consumer> statistics threads through lock-free rings, same results as -J\n");
 				std::exit(EXIT_FAILURE);
 		}
 	}
-	if (options.n_measure == 0 && do_test == false)
+	if (options.n_measure == 0 && do_test == false && !options.resume && options.n_extend == 0)
 	{
 		fprintf(stderr, "ERROR: -n <unsigned int> required\n");
 		std::exit(EXIT_FAILURE);
 	}
+	if (options.decimation < 1)
+	{
+		fprintf(stderr, "ERROR: -D <factor> must be at least 1\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (options.with_alignment && (options.with_bit_leakage || options.fir_taps.size() > 0 || options.decimation > 1 || options.save_traces))
+	{
+		fprintf(stderr, "ERROR: -a can not be combined with -b, -F, -D or -s\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (options.with_hotspots && options.decimation > 1)
+	{
+		fprintf(stderr, "ERROR: -r can not be combined with -D\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (options.n_thread < 1)
+	{
+		fprintf(stderr, "ERROR: -j <n_thread> must be at least 1\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (options.n_worker < 1)
+	{
+		fprintf(stderr, "ERROR: -J <n_worker> must be at least 1\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (options.t_test_order < 1 || options.t_test_order > MAX_T_TEST_ORDER)
+	{
+		fprintf(stderr, "ERROR: -d <order> must be between 1 and %u\n", MAX_T_TEST_ORDER);
+		std::exit(EXIT_FAILURE);
+	}
+	if (options.with_alignment && options.t_test_order > 1)
+	{
+		fprintf(stderr, "ERROR: -a can not be combined with -d\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (options.bivariate_window > 0 && options.poi.size() > 0)
+	{
+		fprintf(stderr, "ERROR: -W and -P are exclusive\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (options.poi.size() == 1)
+	{
+		fprintf(stderr, "ERROR: -P requires at least 2 points of interest\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (options.with_alignment && (options.bivariate_window > 0 || options.poi.size() > 0))
+	{
+		fprintf(stderr, "ERROR: -a can not be combined with -W or -P\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (options.with_alignment && (options.state_filename != "" || options.merge_filenames.size() > 0))
+	{
+		fprintf(stderr, "ERROR: -a can not be combined with -S or -m\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (options.stop_threshold > 0.0 && options.convergence_ppd == 0)
+	{
+		options.convergence_ppd = 10;
+	}
+	if (options.resume && options.n_extend > 0)
+	{
+		fprintf(stderr, "ERROR: -R and -E are exclusive\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (options.with_alignment && (options.checkpoint_interval > 0 || options.resume || options.n_extend > 0))
+	{
+		fprintf(stderr, "ERROR: -a can not be combined with -C, -R or -E\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (options.with_alignment && (options.with_cpa || options.with_histogram || options.with_information || options.template_poi.size() > 0 || options.with_hotspots || options.with_control || options.anova_classes != ANOVA_NONE || options.n_thread > 1 || options.sparse_buckets > 0))
+	{
+		fprintf(stderr, "ERROR: -a can not be combined with -K, -H, -I, -T, -r, -x, -A, -j or -z\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (options.n_worker > 1 && options.n_producer > 0)
+	{
+		fprintf(stderr, "ERROR: -J and -L are exclusive\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if ((options.n_worker > 1 || options.n_producer > 0) && (options.with_alignment || options.save_traces || options.with_gdb || options.checkpoint_interval > 0
+		|| options.resume || options.n_extend > 0 || options.convergence_ppd > 0 || options.with_hotspots))
+	{
+		fprintf(stderr, "ERROR: -J and -L can not be combined with -a, -s, -g, -C, -R, -E, -c, -e or -r\n");
+		std::exit(EXIT_FAILURE);
+	}
+	if (options.save_traces && (options.resume || options.n_extend > 0))
+	{
+		fprintf(stderr, "ERROR: -s can not be combined with -R or -E\n");
+		std::exit(EXIT_FAILURE);
+	}
 	
 	if (do_test)
 	{
@@ -0,0 +1,106 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Sparse t-test results
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "npy.h"
+#include "sparse_result.h"
+
+
+void save_sparse_ttest(std::string json_filename, std::string envelope_filename, const std::vector<double> &t,
+	double threshold, unsigned int n_bucket, const std::vector<uint32_t> &pc_trace,
+	const std::vector<const char *> &source_trace)
+{
+	unsigned long int n_sample = t.size();
+	unsigned long int bucket_size = (n_sample + n_bucket - 1)/n_bucket;
+	bool with_pc = (pc_trace.size() == n_sample && source_trace.size() == n_sample);
+	std::vector<double> envelope;
+	std::vector<unsigned long int> crossings;
+	double max = 0.0;
+	unsigned long int max_sample = 0;
+
+	bucket_size = (bucket_size > 0) ? bucket_size : 1;
+	for (unsigned long int i0 = 0; i0 < n_sample; i0 += bucket_size)
+	{
+		/* fmin and fmax ignore the NaN of constant samples */
+		double lo = NAN;
+		double hi = NAN;
+		for (unsigned long int i = i0; i < i0 + bucket_size && i < n_sample; ++i)
+		{
+			lo = fmin(lo, t[i]);
+			hi = fmax(hi, t[i]);
+			if (fabs(t[i]) > max)
+			{
+				max = fabs(t[i]);
+				max_sample = i;
+			}
+			if (fabs(t[i]) > threshold)
+			{
+				crossings.push_back(i);
+			}
+		}
+		envelope.push_back(lo);
+		envelope.push_back(hi);
+	}
+	save_npy(envelope_filename, envelope, 2);
+
+	FILE *json = fopen(json_filename.c_str(), "w");
+	if (json == NULL)
+	{
+		fprintf(stderr, "-- ERROR: can not write the sparse t-test %s\n", json_filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	fprintf(json, "{\n\t\"n_sample\": %lu,\n\t\"threshold\": %.17g,\n\t\"max_abs_t\": %.17g,\n\t\"max_sample\": %lu,\n",
+		n_sample, threshold, max, max_sample);
+	fprintf(json, "\t\"n_crossing\": %lu,\n\t\"envelope\": \"%s\",\n\t\"bucket_size\": %lu,\n\t\"crossings\": [",
+		static_cast<unsigned long int>(crossings.size()), envelope_filename.c_str(), bucket_size);
+	for (unsigned long int k = 0; k < crossings.size(); ++k)
+	{
+		unsigned long int i = crossings[k];
+		fprintf(json, "%s\n\t\t{\"sample\": %lu, \"t\": %.17g, ", (k == 0) ? "" : ",", i, t[i]);
+		if (with_pc)
+		{
+			/* register names and "mem" need no escaping */
+			fprintf(json, "\"pc\": %u, \"source\": \"%s\"}", pc_trace[i], (source_trace[i] != nullptr) ? source_trace[i] : "-");
+		}
+		else
+		{
+			fprintf(json, "\"pc\": null, \"source\": null}");
+		}
+	}
+	fprintf(json, "\n\t]\n}\n");
+	fclose(json);
+}
@@ -0,0 +1,259 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Binary state files of the statistics accumulators
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "state_file.h"
+
+#define STATE_FILE_MAGIC "LEAKSTAT"
+#define STATE_FILE_BOM 0x01020304
+
+
+State_writer::State_writer(std::string filename)
+{
+	uint32_t header[2] = {STATE_FILE_VERSION, STATE_FILE_BOM};
+
+	this->filename = filename;
+	this->tmp_filename = filename + ".tmp";
+	this->file = fopen(this->tmp_filename.c_str(), "wb");
+	if (this->file == NULL)
+	{
+		fprintf(stderr, "-- ERROR: can not create %s\n", this->tmp_filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	this->write_raw(STATE_FILE_MAGIC, 8);
+	this->write_raw(header, sizeof(header));
+}
+
+State_writer::~State_writer()
+{
+	this->close();
+}
+
+void State_writer::write_raw(const void *data, size_t size)
+{
+	if (size > 0 && fwrite(data, size, 1, this->file) != 1)
+	{
+		fprintf(stderr, "-- ERROR: can not write %s\n", this->tmp_filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+void State_writer::write_tag(std::string tag)
+{
+	this->write_string(tag);
+}
+
+void State_writer::write_string(std::string str)
+{
+	this->write_u64(str.length());
+	this->write_raw(str.data(), str.length());
+}
+
+void State_writer::write_u64(uint64_t value)
+{
+	this->write_raw(&value, sizeof(value));
+}
+
+void State_writer::write_f64(double value)
+{
+	this->write_raw(&value, sizeof(value));
+}
+
+void State_writer::write(const std::vector<uint32_t> &vec)
+{
+	this->write_u64(vec.size());
+	this->write_raw(vec.data(), sizeof(uint32_t)*vec.size());
+}
+
+void State_writer::write(const std::vector<uint64_t> &vec)
+{
+	this->write_u64(vec.size());
+	this->write_raw(vec.data(), sizeof(uint64_t)*vec.size());
+}
+
+void State_writer::write(const std::vector<double> &vec)
+{
+	this->write_u64(vec.size());
+	this->write_raw(vec.data(), sizeof(double)*vec.size());
+}
+
+/* flush to disk before the rename, the rename itself is atomic */
+void State_writer::close(void)
+{
+	if (this->file == NULL)
+	{
+		return;
+	}
+	if (fflush(this->file) != 0 || fsync(fileno(this->file)) != 0 || fclose(this->file) != 0)
+	{
+		fprintf(stderr, "-- ERROR: can not write %s\n", this->tmp_filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	this->file = NULL;
+	if (rename(this->tmp_filename.c_str(), this->filename.c_str()) != 0)
+	{
+		fprintf(stderr, "-- ERROR: can not rename %s to %s\n", this->tmp_filename.c_str(), this->filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+
+
+State_reader::State_reader(std::string filename)
+{
+	char magic[8];
+	uint32_t header[2];
+
+	this->filename = filename;
+	this->file = fopen(filename.c_str(), "rb");
+	if (this->file == NULL)
+	{
+		fprintf(stderr, "-- ERROR: can not open %s\n", filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	this->read_raw(magic, 8);
+	if (memcmp(magic, STATE_FILE_MAGIC, 8) != 0)
+	{
+		fprintf(stderr, "-- ERROR: %s is not a state file\n", filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	this->read_raw(header, sizeof(header));
+	if (header[1] != STATE_FILE_BOM)
+	{
+		fprintf(stderr, "-- ERROR: %s was written on a host with another byte order\n", filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	if (header[0] != STATE_FILE_VERSION)
+	{
+		fprintf(stderr, "-- ERROR: %s has version %u, expected %u\n", filename.c_str(), header[0], STATE_FILE_VERSION);
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+State_reader::~State_reader()
+{
+	if (this->file != NULL)
+	{
+		fclose(this->file);
+	}
+}
+
+std::string State_reader::get_filename(void) const
+{
+	return this->filename;
+}
+
+void State_reader::read_raw(void *data, size_t size)
+{
+	if (size > 0 && fread(data, size, 1, this->file) != 1)
+	{
+		fprintf(stderr, "-- ERROR: %s is truncated\n", this->filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+/* item count of a vector, checked against the remaining file size */
+uint64_t State_reader::read_count(size_t item_size)
+{
+	uint64_t count = this->read_u64();
+	long int pos = ftell(this->file);
+
+	fseek(this->file, 0, SEEK_END);
+	long int end = ftell(this->file);
+	fseek(this->file, pos, SEEK_SET);
+	if (count > static_cast<uint64_t>(end - pos)/item_size)
+	{
+		fprintf(stderr, "-- ERROR: %s is truncated\n", this->filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+	return count;
+}
+
+void State_reader::read_tag(std::string expected_tag)
+{
+	std::string tag = this->read_string();
+
+	if (tag != expected_tag)
+	{
+		fprintf(stderr, "-- ERROR: %s: found %s state, expected %s\n", this->filename.c_str(), tag.c_str(), expected_tag.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+std::string State_reader::read_string(void)
+{
+	uint64_t length = this->read_count(1);
+	std::string str(length, '\0');
+
+	this->read_raw(&str[0], length);
+	return str;
+}
+
+uint64_t State_reader::read_u64(void)
+{
+	uint64_t value;
+
+	this->read_raw(&value, sizeof(value));
+	return value;
+}
+
+double State_reader::read_f64(void)
+{
+	double value;
+
+	this->read_raw(&value, sizeof(value));
+	return value;
+}
+
+void State_reader::read(std::vector<uint32_t> &vec)
+{
+	vec.resize(this->read_count(sizeof(uint32_t)));
+	this->read_raw(vec.data(), sizeof(uint32_t)*vec.size());
+}
+
+void State_reader::read(std::vector<uint64_t> &vec)
+{
+	vec.resize(this->read_count(sizeof(uint64_t)));
+	this->read_raw(vec.data(), sizeof(uint64_t)*vec.size());
+}
+
+void State_reader::read(std::vector<double> &vec)
+{
+	vec.resize(this->read_count(sizeof(double)));
+	this->read_raw(vec.data(), sizeof(double)*vec.size());
+}
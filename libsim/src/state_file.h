@@ -0,0 +1,94 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Binary state files of the statistics accumulators
+ *
+ ******************************************************************************/
+
+#ifndef __STATE_FILE_H__
+#define __STATE_FILE_H__
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/* A state file starts with the magic "LEAKSTAT", the format version and a
+   byte order mark, followed by tagged sections written by the accumulators:
+   each section starts with the class name so that loading the wrong state is
+   detected. Scalars are 64-bit, vectors are a 64-bit item count followed by
+   the raw items, in host byte order.
+   The file is written to <filename>.tmp and renamed by close(), so an
+   existing state is never left half written */
+#define STATE_FILE_VERSION 8
+
+class State_writer
+{
+	private:
+		std::string filename;
+		std::string tmp_filename;
+		FILE *file;
+
+		void write_raw(const void *data, size_t size);
+
+	public:
+		State_writer(std::string filename);
+		~State_writer();
+		void write_tag(std::string tag);
+		void write_string(std::string str);
+		void write_u64(uint64_t value);
+		void write_f64(double value);
+		void write(const std::vector<uint32_t> &vec);
+		void write(const std::vector<uint64_t> &vec);
+		void write(const std::vector<double> &vec);
+		void close(void);
+};
+
+class State_reader
+{
+	private:
+		std::string filename;
+		FILE *file;
+
+		void read_raw(void *data, size_t size);
+		uint64_t read_count(size_t item_size);
+
+	public:
+		State_reader(std::string filename);
+		~State_reader();
+		std::string get_filename(void) const;
+		void read_tag(std::string expected_tag);
+		std::string read_string(void);
+		uint64_t read_u64(void);
+		double read_f64(void);
+		void read(std::vector<uint32_t> &vec);
+		void read(std::vector<uint64_t> &vec);
+		void read(std::vector<double> &vec);
+};
+
+#endif
@@ -36,6 +36,20 @@
 #include "t_test.h"
 
 
+/* Chan et al. parallel update: merges the mean m_b and sum of squared
+   deviations v_b of n_b values into (n_a, m_a, v_a) */
+static void merge_moments(unsigned long int n_a, double &m_a, double &v_a, unsigned long int n_b, double m_b, double v_b)
+{
+	if (n_b == 0)
+	{
+		return;
+	}
+	double n = static_cast<double>(n_a) + n_b;
+	double delta = m_b - m_a;
+	m_a += delta*n_b/n;
+	v_a += v_b + delta*delta*n_a*n_b/n;
+}
+
 Ttest::Ttest(unsigned int n_sample)
 {
 	this->n_sample = n_sample;
@@ -65,6 +79,16 @@ void Ttest::reset(void)
 	this->n2 = 0;
 }
 
+/* append a sample that had the same value in all the traces seen so far */
+void Ttest::add_constant_sample(double value)
+{
+	this->n_sample++;
+	this->m1.push_back(value);
+	this->v1.push_back(0.0);
+	this->m2.push_back(value);
+	this->v2.push_back(0.0);
+}
+
 void Ttest::update1(std::vector<unsigned int> vec)
 {
 	double delta1;
@@ -95,6 +119,45 @@ void Ttest::update2(std::vector<unsigned int> vec)
 	this->n2++;
 }
 
+void Ttest::merge(const Ttest &other)
+{
+	if (other.n_sample != this->n_sample)
+	{
+		fprintf(stderr, "-- ERROR: can not merge t-tests of %u and %u samples\n", this->n_sample, other.n_sample);
+		std::exit(EXIT_FAILURE);
+	}
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		merge_moments(this->n1, this->m1[i], this->v1[i], other.n1, other.m1[i], other.v1[i]);
+		merge_moments(this->n2, this->m2[i], this->v2[i], other.n2, other.m2[i], other.v2[i]);
+	}
+	this->n1 += other.n1;
+	this->n2 += other.n2;
+}
+
+void Ttest::save(State_writer &writer) const
+{
+	writer.write_tag("Ttest");
+	writer.write_u64(this->n1);
+	writer.write_u64(this->n2);
+	writer.write(this->m1);
+	writer.write(this->v1);
+	writer.write(this->m2);
+	writer.write(this->v2);
+}
+
+void Ttest::load(State_reader &reader)
+{
+	reader.read_tag("Ttest");
+	this->n1 = reader.read_u64();
+	this->n2 = reader.read_u64();
+	reader.read(this->m1);
+	reader.read(this->v1);
+	reader.read(this->m2);
+	reader.read(this->v2);
+	this->n_sample = this->m1.size();
+}
+
 std::vector<double> Ttest::t_test(void)
 {
 	std::vector<double> t;
@@ -122,3 +185,138 @@ std::vector<double> Ttest::t_test(void)
 	}
 	return t;
 }
+
+
+
+Aligned_ttest::Aligned_ttest()
+{
+	this->n_sample = 0;
+}
+
+Aligned_ttest::~Aligned_ttest()
+{
+}
+
+void Aligned_ttest::resize(unsigned int n_sample)
+{
+	this->n_sample = n_sample;
+	this->n1.resize(n_sample, 0);
+	this->m1.resize(n_sample, 0.0);
+	this->v1.resize(n_sample, 0.0);
+	this->n2.resize(n_sample, 0);
+	this->m2.resize(n_sample, 0.0);
+	this->v2.resize(n_sample, 0.0);
+}
+
+void Aligned_ttest::update1(const std::vector<unsigned int> &vec, const std::vector<unsigned int> &ids)
+{
+	double delta1;
+	double delta2;
+
+	for (unsigned int k = 0; k < ids.size(); ++k)
+	{
+		unsigned int i = ids[k];
+		if (i >= this->n_sample)
+		{
+			this->resize(i + 1);
+		}
+		delta1 = static_cast<double>(vec[k]) - this->m1[i];
+		this->m1[i] += delta1/(this->n1[i] + 1);
+		delta2 = static_cast<double>(vec[k]) - this->m1[i];
+		this->v1[i] += delta1*delta2;
+		this->n1[i]++;
+	}
+}
+
+void Aligned_ttest::update2(const std::vector<unsigned int> &vec, const std::vector<unsigned int> &ids)
+{
+	double delta1;
+	double delta2;
+
+	for (unsigned int k = 0; k < ids.size(); ++k)
+	{
+		unsigned int i = ids[k];
+		if (i >= this->n_sample)
+		{
+			this->resize(i + 1);
+		}
+		delta1 = static_cast<double>(vec[k]) - this->m2[i];
+		this->m2[i] += delta1/(this->n2[i] + 1);
+		delta2 = static_cast<double>(vec[k]) - this->m2[i];
+		this->v2[i] += delta1*delta2;
+		this->n2[i]++;
+	}
+}
+
+/* both tests must use the same sample ids, i.e. the same alignment */
+void Aligned_ttest::merge(const Aligned_ttest &other)
+{
+	if (other.n_sample > this->n_sample)
+	{
+		this->resize(other.n_sample);
+	}
+	for (unsigned int i = 0; i < other.n_sample; ++i)
+	{
+		merge_moments(this->n1[i], this->m1[i], this->v1[i], other.n1[i], other.m1[i], other.v1[i]);
+		merge_moments(this->n2[i], this->m2[i], this->v2[i], other.n2[i], other.m2[i], other.v2[i]);
+		this->n1[i] += other.n1[i];
+		this->n2[i] += other.n2[i];
+	}
+}
+
+void Aligned_ttest::save(State_writer &writer) const
+{
+	std::vector<uint64_t> n1(this->n1.begin(), this->n1.end());
+	std::vector<uint64_t> n2(this->n2.begin(), this->n2.end());
+
+	writer.write_tag("Aligned_ttest");
+	writer.write(n1);
+	writer.write(this->m1);
+	writer.write(this->v1);
+	writer.write(n2);
+	writer.write(this->m2);
+	writer.write(this->v2);
+}
+
+void Aligned_ttest::load(State_reader &reader)
+{
+	std::vector<uint64_t> n1;
+	std::vector<uint64_t> n2;
+
+	reader.read_tag("Aligned_ttest");
+	reader.read(n1);
+	reader.read(this->m1);
+	reader.read(this->v1);
+	reader.read(n2);
+	reader.read(this->m2);
+	reader.read(this->v2);
+	this->n1.assign(n1.begin(), n1.end());
+	this->n2.assign(n2.begin(), n2.end());
+	this->n_sample = this->n1.size();
+}
+
+/* samples seen less than twice in a class get t = 0 */
+std::vector<double> Aligned_ttest::t_test(void)
+{
+	std::vector<double> t;
+	double term;
+
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		if (this->n1[i] < 2 || this->n2[i] < 2)
+		{
+			t.push_back(0.0);
+			continue;
+		}
+		term = sqrt(this->v1[i]/(this->n1[i] - 1)/this->n1[i] + this->v2[i]/(this->n2[i] - 1)/this->n2[i]);
+		if (term == 0.0)
+		{
+			t.push_back(0.0);
+		}
+		else
+		{
+			t.push_back((this->m1[i] - this->m2[i])/term);
+		}
+	}
+	return t;
+}
@@ -34,6 +34,7 @@
 #define __T_TEST_H__
 
 #include <vector>
+#include "state_file.h"
 
 class Ttest
 {
@@ -50,8 +51,38 @@ class Ttest
 		Ttest(unsigned int n_sample);
 		~Ttest();
 		void reset(void);
+		void add_constant_sample(double value);
 		void update1(std::vector<unsigned int> vec);
 		void update2(std::vector<unsigned int> vec);
+		void merge(const Ttest &other);
+		void save(State_writer &writer) const;
+		void load(State_reader &reader);
+		std::vector<double> t_test(void);
+};
+
+/* Welch t-test where each trace only covers some of the samples (given by
+   their ids), hence one count per sample and per class */
+class Aligned_ttest
+{
+	private:
+		unsigned int n_sample;
+		std::vector<unsigned long int> n1;
+		std::vector<unsigned long int> n2;
+		std::vector<double> v1;
+		std::vector<double> v2;
+		std::vector<double> m1;
+		std::vector<double> m2;
+
+		void resize(unsigned int n_sample);
+
+	public:
+		Aligned_ttest();
+		~Aligned_ttest();
+		void update1(const std::vector<unsigned int> &vec, const std::vector<unsigned int> &ids);
+		void update2(const std::vector<unsigned int> &vec, const std::vector<unsigned int> &ids);
+		void merge(const Aligned_ttest &other);
+		void save(State_writer &writer) const;
+		void load(State_reader &reader);
 		std::vector<double> t_test(void);
 };
 
@@ -0,0 +1,276 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Template (profiling) accumulators
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include "template_builder.h"
+#include "utils.h"
+
+/* traces buffered before the scatter matrix is updated */
+#define BATCH_SIZE 64
+/* 65535*255^2 < 2^32 */
+#define MAX_PENDING 65535
+/* rows of the scatter matrix kept in L1 while a batch is added */
+#define TILE_ROW 16
+
+
+/* sxx[a][b] += sum_k x[k][a] x[k][b] for b >= a and the rows a0..a1-1 */
+AVX2_CLONES
+static void add_scatter(uint32_t *sxx, const uint32_t *x, unsigned int n_batch, unsigned int n_poi,
+	unsigned int a0, unsigned int a1)
+{
+	for (unsigned int k = 0; k < n_batch; ++k)
+	{
+		const uint32_t *xk = x + k*n_poi;
+		for (unsigned int a = a0; a < a1; ++a)
+		{
+			const uint32_t xa = xk[a];
+			uint32_t *row = sxx + static_cast<unsigned long int>(a)*n_poi;
+			for (unsigned int b = a; b < n_poi; ++b)
+			{
+				row[b] += xa*xk[b];
+			}
+		}
+	}
+}
+
+
+Template_builder::Template_builder(unsigned int n_poi, unsigned int n_class)
+{
+	this->n_poi = n_poi;
+	this->n_class = n_class;
+	this->reset();
+}
+
+Template_builder::~Template_builder()
+{
+}
+
+void Template_builder::reset(void)
+{
+	this->n = 0;
+	this->n_pending = 0;
+	this->n_batch = 0;
+	this->n_c.assign(this->n_class, 0);
+	this->s.assign(static_cast<unsigned long int>(this->n_class)*this->n_poi, 0);
+	this->sxx.assign(static_cast<unsigned long int>(this->n_poi)*this->n_poi, 0);
+	this->sxx_32.assign(static_cast<unsigned long int>(this->n_poi)*this->n_poi, 0);
+	this->batch.assign(BATCH_SIZE*this->n_poi, 0);
+}
+
+unsigned int Template_builder::get_n_poi(void) const
+{
+	return this->n_poi;
+}
+
+unsigned int Template_builder::get_n_class(void) const
+{
+	return this->n_class;
+}
+
+/* vec holds the samples at the points of interest, cls the class of the trace */
+void Template_builder::update(const std::vector<unsigned int> &vec, unsigned int cls)
+{
+	if (cls >= this->n_class)
+	{
+		fprintf(stderr, "-- ERROR: template class %u out of [0, %u)\n", cls, this->n_class);
+		std::exit(EXIT_FAILURE);
+	}
+
+	uint32_t *x = this->batch.data() + this->n_batch*this->n_poi;
+	uint64_t *sc = this->s.data() + static_cast<unsigned long int>(cls)*this->n_poi;
+
+	for (unsigned int a = 0; a < this->n_poi; ++a)
+	{
+		if (vec[a] > 255)
+		{
+			fprintf(stderr, "-- ERROR: sample value %u does not fit in 8 bits\n", vec[a]);
+			std::exit(EXIT_FAILURE);
+		}
+		x[a] = vec[a];
+		sc[a] += x[a];
+	}
+	this->n_c[cls]++;
+	this->n++;
+	if (++this->n_batch == BATCH_SIZE)
+	{
+		this->flush_batch();
+	}
+}
+
+void Template_builder::flush_batch(void)
+{
+	if (this->n_batch == 0)
+	{
+		return;
+	}
+	if (this->n_pending + this->n_batch > MAX_PENDING)
+	{
+		this->flush();
+	}
+	for (unsigned int a0 = 0; a0 < this->n_poi; a0 += TILE_ROW)
+	{
+		unsigned int a1 = (a0 + TILE_ROW < this->n_poi) ? a0 + TILE_ROW : this->n_poi;
+		add_scatter(this->sxx_32.data(), this->batch.data(), this->n_batch, this->n_poi, a0, a1);
+	}
+	this->n_pending += this->n_batch;
+	this->n_batch = 0;
+}
+
+void Template_builder::flush(void)
+{
+	for (unsigned long int k = 0; k < this->sxx.size(); ++k)
+	{
+		this->sxx[k] += this->sxx_32[k];
+		this->sxx_32[k] = 0;
+	}
+	this->n_pending = 0;
+}
+
+std::vector<double> Template_builder::counts(void) const
+{
+	return std::vector<double>(this->n_c.begin(), this->n_c.end());
+}
+
+/* (n_class, n_poi) matrix of the class means, 0 for the classes never seen */
+std::vector<double> Template_builder::means(void) const
+{
+	std::vector<double> m(this->s.size(), 0.0);
+
+	for (unsigned int c = 0; c < this->n_class; ++c)
+	{
+		for (unsigned int a = 0; a < this->n_poi && this->n_c[c] > 0; ++a)
+		{
+			m[c*this->n_poi + a] = static_cast<double>(this->s[c*this->n_poi + a])/this->n_c[c];
+		}
+	}
+	return m;
+}
+
+/* (n_poi, n_poi) within-class scatter divided by n - (number of classes seen) */
+std::vector<double> Template_builder::pooled_covariance(void)
+{
+	std::vector<double> cov(static_cast<unsigned long int>(this->n_poi)*this->n_poi, 0.0);
+	unsigned int n_seen = 0;
+
+	this->flush_batch();
+	this->flush();
+	for (unsigned int c = 0; c < this->n_class; ++c)
+	{
+		n_seen += (this->n_c[c] > 0);
+	}
+	if (this->n <= n_seen)
+	{
+		return cov;
+	}
+	for (unsigned int a = 0; a < this->n_poi; ++a)
+	{
+		for (unsigned int b = a; b < this->n_poi; ++b)
+		{
+			long double between = 0.0L;
+			for (unsigned int c = 0; c < this->n_class; ++c)
+			{
+				if (this->n_c[c] > 0)
+				{
+					between += static_cast<long double>(this->s[c*this->n_poi + a])*this->s[c*this->n_poi + b]/this->n_c[c];
+				}
+			}
+			double v = (this->sxx[a*this->n_poi + b] - between)/(this->n - n_seen);
+			cov[a*this->n_poi + b] = v;
+			cov[b*this->n_poi + a] = v;
+		}
+	}
+	return cov;
+}
+
+void Template_builder::merge(const Template_builder &other)
+{
+	if (other.n_poi != this->n_poi || other.n_class != this->n_class)
+	{
+		fprintf(stderr, "-- ERROR: can not merge templates of %u points x %u classes and %u points x %u classes\n",
+			this->n_poi, this->n_class, other.n_poi, other.n_class);
+		std::exit(EXIT_FAILURE);
+	}
+	this->flush_batch();
+	this->flush();
+	for (unsigned long int k = 0; k < this->sxx.size(); ++k)
+	{
+		this->sxx[k] += other.sxx[k] + other.sxx_32[k];
+	}
+	/* the pending batch of other is only in its buffer */
+	this->batch.assign(other.batch.begin(), other.batch.end());
+	this->n_batch = other.n_batch;
+	this->flush_batch();
+	for (unsigned long int k = 0; k < this->s.size(); ++k)
+	{
+		this->s[k] += other.s[k];
+	}
+	for (unsigned int c = 0; c < this->n_class; ++c)
+	{
+		this->n_c[c] += other.n_c[c];
+	}
+	this->n += other.n;
+}
+
+void Template_builder::save(State_writer &writer)
+{
+	this->flush_batch();
+	this->flush();
+	writer.write_tag("Template_builder");
+	writer.write_u64(this->n_poi);
+	writer.write_u64(this->n_class);
+	writer.write_u64(this->n);
+	writer.write(this->n_c);
+	writer.write(this->s);
+	writer.write(this->sxx);
+}
+
+void Template_builder::load(State_reader &reader)
+{
+	reader.read_tag("Template_builder");
+	this->n_poi = reader.read_u64();
+	this->n_class = reader.read_u64();
+	this->reset();
+	this->n = reader.read_u64();
+	reader.read(this->n_c);
+	reader.read(this->s);
+	reader.read(this->sxx);
+	if (this->n_c.size() != this->n_class || this->s.size() != static_cast<unsigned long int>(this->n_class)*this->n_poi ||
+		this->sxx.size() != static_cast<unsigned long int>(this->n_poi)*this->n_poi)
+	{
+		fprintf(stderr, "-- ERROR: %s: inconsistent templates\n", reader.get_filename().c_str());
+		std::exit(EXIT_FAILURE);
+	}
+}
@@ -0,0 +1,79 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Template (profiling) accumulators
+ *
+ ******************************************************************************/
+
+#ifndef __TEMPLATE_BUILDER_H__
+#define __TEMPLATE_BUILDER_H__
+
+#include <cstdint>
+#include <vector>
+#include "state_file.h"
+
+/* Gaussian templates on n_poi points of interest for n_class classes (values
+   of an intermediate): the mean of each class and the covariance pooled over
+   the classes. With 8-bit samples the per-class sums and the scatter matrix
+   sum x x^T are exact integers, and the pooled (within-class) scatter is
+   sum x x^T - sum_c s_c s_c^T/n_c. Traces are buffered by batches, the
+   scatter matrix being updated by a rank-k product of the batch into 32-bit
+   sums flushed to 64-bit sums before they can overflow */
+class Template_builder
+{
+	private:
+		unsigned int n_poi;
+		unsigned int n_class;
+		unsigned long int n;
+		std::vector<uint64_t> n_c;         /* per class */
+		std::vector<uint64_t> s;           /* sum of x at c*n_poi + a */
+		std::vector<uint64_t> sxx;         /* upper triangle of sum x x^T at a*n_poi + b */
+		std::vector<uint32_t> sxx_32;
+		unsigned int n_pending;            /* traces in sxx_32 */
+		unsigned int n_batch;              /* traces in the batch */
+		std::vector<uint32_t> batch;
+
+		void flush_batch(void);
+		void flush(void);
+
+	public:
+		Template_builder(unsigned int n_poi, unsigned int n_class);
+		~Template_builder();
+		void reset(void);
+		unsigned int get_n_poi(void) const;
+		unsigned int get_n_class(void) const;
+		void update(const std::vector<unsigned int> &vec, unsigned int cls);
+		std::vector<double> counts(void) const;
+		std::vector<double> means(void) const;
+		std::vector<double> pooled_covariance(void);
+		void merge(const Template_builder &other);
+		void save(State_writer &writer);
+		void load(State_reader &reader);
+};
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Batch of traces with duplicates merged
+ *
+ ******************************************************************************/
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "trace_batch.h"
+#include "utils.h"
+
+
+/* FNV-1a on 64-bit words, then on the remaining bytes */
+uint64_t hash_samples(const uint8_t *x, unsigned int n)
+{
+	uint64_t h = FNV_OFFSET;
+	unsigned int i = 0;
+
+	for (; i + 8 <= n; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, x + i, sizeof(word));
+		h = fnv1a(h, word);
+	}
+	for (; i < n; ++i)
+	{
+		h = fnv1a(h, x[i]);
+	}
+	return h;
+}
+
+Trace_batch::Trace_batch()
+{
+	this->clear();
+}
+
+Trace_batch::~Trace_batch()
+{
+}
+
+void Trace_batch::clear(void)
+{
+	this->n_sample = 0;
+	this->n_trace = 0;
+	this->rows.clear();
+	this->weights.clear();
+	this->hashes.clear();
+}
+
+void Trace_batch::add(const std::vector<unsigned int> &trace)
+{
+	if (this->n_trace == 0)
+	{
+		this->n_sample = trace.size();
+		this->buffer.resize(this->n_sample);
+	}
+	for (unsigned int i = 0; i < this->n_sample; ++i)
+	{
+		this->buffer[i] = trace[i];
+	}
+	uint64_t h = hash_samples(this->buffer.data(), this->n_sample);
+	this->n_trace++;
+	for (unsigned int k = 0; k < this->hashes.size(); ++k)
+	{
+		if (this->hashes[k] == h && memcmp(this->rows.data() + static_cast<unsigned long int>(k)*this->n_sample,
+			this->buffer.data(), this->n_sample) == 0)
+		{
+			this->weights[k]++;
+			return;
+		}
+	}
+	this->rows.insert(this->rows.end(), this->buffer.begin(), this->buffer.end());
+	this->weights.push_back(1);
+	this->hashes.push_back(h);
+}
+
+bool Trace_batch::empty(void) const
+{
+	return (this->n_trace == 0);
+}
+
+unsigned int Trace_batch::get_n_trace(void) const
+{
+	return this->n_trace;
+}
+
+unsigned int Trace_batch::get_n_row(void) const
+{
+	return this->weights.size();
+}
+
+const uint8_t *Trace_batch::get_rows(void) const
+{
+	return this->rows.data();
+}
+
+const unsigned int *Trace_batch::get_weights(void) const
+{
+	return this->weights.data();
+}
@@ -0,0 +1,143 @@
+/*
+ *
+ * University of Luxembourg
+ * Laboratory of Algorithmics, Cryptology and Security (LACS)
+ *
+ * arm_v7m_leakage simulator
+ *
+ * Copyright (C) 2017 University of Luxembourg
+ *
+ * Written in 2017 by Yann Le Corre <yann.lecorre@uni.lu>
+ *
+ * This simulator is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/******************************************************************************
+ *
+ * Lock-free ring of trace blocks between simulation and statistics threads
+ *
+ ******************************************************************************/
+
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include "trace_ring.h"
+
+
+Trace_ring::Trace_ring(unsigned int capacity)
+{
+	unsigned long int size = 2;
+
+	while (size < capacity)
+	{
+		size *= 2;
+	}
+	this->cells.reset(new Cell[size]);
+	for (unsigned long int i = 0; i < size; ++i)
+	{
+		this->cells[i].sequence.store(i, std::memory_order_relaxed);
+		this->cells[i].block = nullptr;
+	}
+	this->mask = size - 1;
+	this->head.store(0, std::memory_order_relaxed);
+	this->tail.store(0, std::memory_order_relaxed);
+}
+
+Trace_ring::~Trace_ring()
+{
+}
+
+/* the cell of position pos is free when its sequence is pos, and a full
+   turn behind (sequence pos - capacity + 1) while its block is not popped */
+bool Trace_ring::try_push(Trace_block *block)
+{
+	unsigned long int pos = this->head.load(std::memory_order_relaxed);
+	Cell *cell;
+
+	while (true)
+	{
+		cell = &this->cells[pos & this->mask];
+		long int diff = static_cast<long int>(cell->sequence.load(std::memory_order_acquire) - pos);
+		if (diff == 0)
+		{
+			if (this->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			return false;
+		}
+		else
+		{
+			pos = this->head.load(std::memory_order_relaxed);
+		}
+	}
+	cell->block = block;
+	cell->sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+/* the cell of position pos holds a block when its sequence is pos + 1, and is
+   handed to the push of the next turn */
+bool Trace_ring::try_pop(Trace_block *&block)
+{
+	unsigned long int pos = this->tail.load(std::memory_order_relaxed);
+	Cell *cell;
+
+	while (true)
+	{
+		cell = &this->cells[pos & this->mask];
+		long int diff = static_cast<long int>(cell->sequence.load(std::memory_order_acquire) - (pos + 1));
+		if (diff == 0)
+		{
+			if (this->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			return false;
+		}
+		else
+		{
+			pos = this->tail.load(std::memory_order_relaxed);
+		}
+	}
+	block = cell->block;
+	cell->sequence.store(pos + this->mask + 1, std::memory_order_release);
+	return true;
+}
+
+void Trace_ring::push(Trace_block *block)
+{
+	while (!this->try_push(block))
+	{
+		std::this_thread::yield();
+	}
+}
+
+Trace_block *Trace_ring::pop(void)
+{
+	Trace_block *block;
+
+	while (!this->try_pop(block))
+	{
+		std::this_thread::yield();
+	}
+	return block;
+}
@@ -32,10 +32,13 @@
 
 #include <cstdint>
 #include "tracer.h"
+#include "utils.h"
 
 Tracer::Tracer()
 {
-	/* intentionally empty */
+	this->with_bit_trace = false;
+	this->with_pc_trace = false;
+	this->pc = 0;
 }
 
 Tracer::~Tracer()
@@ -46,12 +49,42 @@ Tracer::~Tracer()
 void Tracer::reset(void)
 {
 	this->trace.clear();
+	this->bit_trace.clear();
+	this->pc_trace.clear();
+	this->source_trace.clear();
 	this->register_write_count = 0;
 }
 
-void Tracer::update(unsigned int value)
+void Tracer::set_bit_trace(bool enable)
+{
+	this->with_bit_trace = enable;
+}
+
+void Tracer::set_pc_trace(bool enable)
+{
+	this->with_pc_trace = enable;
+}
+
+/* address of the instruction being executed, attached to the next events */
+void Tracer::set_pc(uint32_t pc)
+{
+	this->pc = pc;
+}
+
+/* leakage is the mask of the bits that toggled (register) or that are set
+   (memory). The power trace only keeps its Hamming weight */
+void Tracer::update(uint32_t leakage, const char *source)
 {
-	this->trace.push_back(value);
+	this->trace.push_back(bit_count(leakage));
+	if (this->with_bit_trace)
+	{
+		this->bit_trace.push_back(leakage);
+	}
+	if (this->with_pc_trace)
+	{
+		this->pc_trace.push_back(this->pc);
+		this->source_trace.push_back(source);
+	}
 	this->register_write_count++;
 }
 
@@ -60,6 +93,21 @@ std::vector<unsigned int> Tracer::get_trace(void) const
 	return this->trace;
 }
 
+std::vector<uint32_t> Tracer::get_bit_trace(void) const
+{
+	return this->bit_trace;
+}
+
+std::vector<uint32_t> Tracer::get_pc_trace(void) const
+{
+	return this->pc_trace;
+}
+
+std::vector<const char *> Tracer::get_source_trace(void) const
+{
+	return this->source_trace;
+}
+
 unsigned long int Tracer::get_register_write_count(void) const
 {
 	return this->register_write_count;
@@ -68,7 +116,7 @@ unsigned long int Tracer::get_register_write_count(void) const
 
 
 
-void Tracer_none::update(unsigned int value)
+void Tracer_none::update(uint32_t leakage, const char *source)
 {
 	this->register_write_count++;
 }
@@ -40,6 +40,12 @@ class Tracer
 {
 	protected:
 		std::vector<unsigned int> trace;
+		std::vector<uint32_t> bit_trace;      /* transition masks, one 32-bit word per event */
+		bool with_bit_trace;
+		std::vector<uint32_t> pc_trace;       /* address of the instruction of each event */
+		std::vector<const char *> source_trace; /* register ("mem" for memory) of each event, with the pc trace */
+		bool with_pc_trace;
+		uint32_t pc;
 		unsigned long int register_write_count;
 
 	public:
@@ -47,15 +53,21 @@ class Tracer
 		~Tracer();
 
 		void reset(void);
-		void update(unsigned int value);
+		void set_bit_trace(bool enable);
+		void set_pc_trace(bool enable);
+		void set_pc(uint32_t pc);
+		void update(uint32_t leakage, const char *source);
 		std::vector<unsigned int> get_trace(void) const;
+		std::vector<uint32_t> get_bit_trace(void) const;
+		std::vector<uint32_t> get_pc_trace(void) const;
+		std::vector<const char *> get_source_trace(void) const;
 		unsigned long int get_register_write_count(void) const;
 };
 
 
 class Tracer_none : public Tracer
 {
-	void update(unsigned int value);
+	void update(uint32_t leakage, const char *source);
 };
 
 #endif
@@ -33,6 +33,8 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <vector>
+#include "utils.h"
 
 #define USE_ASM_POPCNT
 
@@ -55,3 +57,40 @@ unsigned int bit_count(uint32_t x)
     return h;
 #endif
 }
+
+/* parse a comma separated list of numbers, e.g. "0.25,0.5,0.25" */
+std::vector<double> parse_double_list(const char *str)
+{
+	std::vector<double> list;
+	char *end;
+
+	while (*str != '\0')
+	{
+		list.push_back(strtod(str, &end));
+		if (end == str)
+		{
+			fprintf(stderr, "-- ERROR: can not parse number list '%s'\n", str);
+			std::exit(EXIT_FAILURE);
+		}
+		str = (*end == ',') ? end + 1 : end;
+	}
+	return list;
+}
+
+std::vector<unsigned int> parse_uint_list(const char *str)
+{
+	std::vector<unsigned int> list;
+	char *end;
+
+	while (*str != '\0')
+	{
+		list.push_back(strtoul(str, &end, 0));
+		if (end == str)
+		{
+			fprintf(stderr, "-- ERROR: can not parse number list '%s'\n", str);
+			std::exit(EXIT_FAILURE);
+		}
+		str = (*end == ',') ? end + 1 : end;
+	}
+	return list;
+}
@@ -33,10 +33,28 @@
 #ifndef __UTILS_H__
 #define __UTILS_H__
 
+#include <cstdint>
+#include <vector>
+
 #define GET_BIT(x, n) (((x) >> (n)) & 1)
 #define GET_FIELD(x, start, len) (((x) >> (start)) & ((1 << (len)) - 1))
 
+/* 64-bit FNV-1a, one word at a time: h = fnv1a(h, word) from h = FNV_OFFSET */
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static inline uint64_t fnv1a(uint64_t h, uint64_t word)
+{
+	return (h ^ word)*FNV_PRIME;
+}
+
 unsigned int bit_count(uint32_t x);
+std::vector<double> parse_double_list(const char *str);
+std::vector<unsigned int> parse_uint_list(const char *str);
+
+/* The function is compiled for AVX2 and for the baseline target, and the
+   version matching the CPU is selected when the program is loaded */
+#define AVX2_CLONES __attribute__((target_clones("avx2", "default")))
 
 /* Stringification hacks */
 #define STR_(...) #__VA_ARGS__
@@ -38,9 +38,9 @@ vpath %.cpp ../src
 LIB_DIR := ../../../install/lib
 INC_DIR := ../../../install/include
 
-CFLAGS := -std=gnu++11 -O3 -Wall -I../src -I$(INC_DIR)
+CFLAGS := -std=gnu++11 -O3 -pthread -Wall -I../src -I$(INC_DIR)
 LDFLAGS := -L$(LIB_DIR)
-LIBS := -lsim
+LIBS := -lsim -pthread
 
 %.o: %.cpp
 	g++ -c $(CFLAGS) -o $@ $<
@@ -37,11 +37,9 @@
 #include <iostream>
 #include <fstream>
 #include <unistd.h>
-#include <progress_bar.h>
 #include "options.h"
 #include "cpu.h"
-#include "t_test.h"
-#include "npy.h"
+#include "campaign.h"
 #include "sim_sec_algo.h"
 
 
@@ -114,74 +112,46 @@ void check_sec_algo(Options &options)
 	}
 }
 
-void t_test_sec_algo(Options &options)
+void measure(std::mt19937 &rnd_gen_uint32, Cpu *cpu, Input_class input_class, uint32_t *inputs)
 {
-	Cpu cpu(options);
-	Ttest *ttest_ptr = nullptr;
-	std::random_device random_dev;
-	std::mt19937 rnd_gen_uint32(random_dev());
-	std::vector<unsigned int> trace;
-	std::ofstream trace_file_fixed;
-	std::ofstream trace_file_random;
-
-	load(&cpu);
-	cpu.reset();
-	const uint32_t a_fixed = 0xb1a6f5e5;
-	const uint32_t b_fixed = 0x127cbff6;
-
-	if (options.save_traces)
-	{
-		std::string filename_fixed = "trace_fixed_n_measure_" + std::to_string(options.n_measure) + ".bin";
-		trace_file_fixed.open(filename_fixed, std::ios::out | std::ios::binary);
-		std::string filename_random = "trace_random_n_measure_" + std::to_string(options.n_measure) + ".bin";
-		trace_file_random.open(filename_random, std::ios::out | std::ios::binary);
-	}
+	static const uint32_t a_fixed = 0xb1a6f5e5;
+	static const uint32_t b_fixed = 0x127cbff6;
+	uint32_t a;
+	uint32_t b;
+	uint32_t y;
 
-	Progress_bar progress_bar(options.n_measure, std::cout, "Simulating sec_add_v06 ...\n");
-	for (unsigned long int measure_idx = 0; measure_idx < options.n_measure; ++measure_idx)
+	if (input_class == INPUT_FIXED)
 	{
-		uint32_t a;
-		uint32_t b;
-		uint32_t y;
-		/* fixed */
 		a = a_fixed;
 		b = b_fixed;
-		sec_add_v06_wrapper(rnd_gen_uint32, &cpu, a, b, &y);
-		trace = cpu.get_pwr_trace();
-		if (measure_idx == 0)
-		{
-			ttest_ptr = new Ttest(trace.size());
-		}
-		ttest_ptr->update1(trace);
-		if (options.save_traces)
-		{
-			trace_file_fixed.write((char *)trace.data(), sizeof(unsigned int)*trace.size());
-		}
-		/* random */
-		a = rnd_gen_uint32();
-		b = rnd_gen_uint32();
-		sec_add_v06_wrapper(rnd_gen_uint32, &cpu, a, b, &y);
-		trace = cpu.get_pwr_trace();
-		ttest_ptr->update2(trace);
-		if (options.save_traces)
-		{
-			trace_file_random.write((char *)trace.data(), sizeof(unsigned int)*trace.size());
-		}
-		++progress_bar;
 	}
-
-	std::vector<double> t = ttest_ptr->t_test();
-	save_npy(options.t_test_filename, t);
-
-	if (options.save_traces)
+	else if (input_class == INPUT_FIXED_2)
 	{
-		trace_file_fixed.close();
-		trace_file_random.close();
+		a = ~a_fixed;
+		b = ~b_fixed;
 	}
-
-	if (ttest_ptr != nullptr)
+	else
 	{
-		delete ttest_ptr;
+		a = rnd_gen_uint32();
+		b = rnd_gen_uint32();
 	}
+	inputs[0] = a;
+	inputs[1] = b;
+	sec_add_v06_wrapper(rnd_gen_uint32, cpu, a, b, &y);
 }
 
+
+const Sec_algo sec_algo =
+{
+	"sec_add_v06",
+	2,
+	load,
+	measure
+};
+
+void t_test_sec_algo(Options &options)
+{
+	Campaign campaign(options, sec_algo);
+
+	campaign.run();
+}
@@ -37,10 +37,8 @@
 #include <iostream>
 #include <fstream>
 #include <unistd.h>
-#include <progress_bar.h>
 #include "cpu.h"
-#include "t_test.h"
-#include "npy.h"
+#include "campaign.h"
 #include "options.h"
 #include "sim_sec_algo.h"
 
@@ -149,20 +147,10 @@ void check_sec_algo(Options &options)
 }
 
 
-void t_test_sec_algo(Options &options)
+void measure(std::mt19937 &rnd_gen_uint32, Cpu *cpu, Input_class input_class, uint32_t *inputs)
 {
-	Cpu cpu(options);
-	Ttest *ttest_ptr = nullptr;
-	std::random_device random_dev;
-	std::mt19937 rnd_gen_uint32(random_dev());
-	std::vector<unsigned int> trace;
-	std::ofstream trace_file_fixed;
-	std::ofstream trace_file_random;
-
-	load(&cpu);
-	cpu.reset();
-	uint16_t rows_fixed[] = {0xffff, 0xffff, 0xffff, 0xffff};
-	const uint32_t rk[] =
+	static uint16_t rows_fixed[] = {0xffff, 0xffff, 0xffff, 0xffff};
+	static const uint32_t rk[] =
 	{
 		0xffffffff, 0xffffffff, 0x00ff01ff, 0x00ffff00,
 		0x01000301, 0xfefffeff, 0x02fff802, 0x02010100,
@@ -178,61 +166,48 @@ void t_test_sec_algo(Options &options)
 		0xeef5f3ed, 0x1312f505, 0x1f05f602, 0xf7edf2fd,
 		0xecfde7e0, 0xe5021e0a, 0xea0a0305, 0xf8e0e20b
 	};
+	uint16_t rows[4];
 
-	if (options.save_traces)
+	if (input_class == INPUT_FIXED)
 	{
-		std::string filename_fixed = "trace_fixed_n_measure_" + std::to_string(options.n_measure) + ".bin";
-		trace_file_fixed.open(filename_fixed, std::ios::out | std::ios::binary);
-		std::string filename_random = "trace_random_n_measure_" + std::to_string(options.n_measure) + ".bin";
-		trace_file_random.open(filename_random, std::ios::out | std::ios::binary);
-	}
-
-	Progress_bar progress_bar(options.n_measure, std::cout, "Simulating sec_rectangle_v04 ...\n");
-	for (unsigned long int measure_idx = 0; measure_idx < options.n_measure; ++measure_idx)
-	{
-		uint16_t rows[4];
-		/* fixed */
 		rows[0] = rows_fixed[0];
 		rows[1] = rows_fixed[1];
 		rows[2] = rows_fixed[2];
 		rows[3] = rows_fixed[3];
-		sec_rectangle_v04_wrapper(rnd_gen_uint32, &cpu, rows, rk);
-		trace = cpu.get_pwr_trace();
-		if (measure_idx == 0)
-		{
-			ttest_ptr = new Ttest(trace.size());
-		}
-		ttest_ptr->update1(trace);
-		if (options.save_traces)
-		{
-			trace_file_fixed.write((char *)trace.data(), sizeof(unsigned int)*trace.size());
-		}
-		/* random */
+	}
+	else if (input_class == INPUT_FIXED_2)
+	{
+		rows[0] = rows_fixed[0] ^ 0xffff;
+		rows[1] = rows_fixed[1] ^ 0xffff;
+		rows[2] = rows_fixed[2] ^ 0xffff;
+		rows[3] = rows_fixed[3] ^ 0xffff;
+	}
+	else
+	{
 		rows[0] = rnd_gen_uint32() & 0xffff;
 		rows[1] = rnd_gen_uint32() & 0xffff;
 		rows[2] = rnd_gen_uint32() & 0xffff;
 		rows[3] = rnd_gen_uint32() & 0xffff;
-		sec_rectangle_v04_wrapper(rnd_gen_uint32, &cpu, rows, rk);
-		trace = cpu.get_pwr_trace();
-		ttest_ptr->update2(trace);
-		if (options.save_traces)
-		{
-			trace_file_random.write((char *)trace.data(), sizeof(unsigned int)*trace.size());
-		}
-		++progress_bar;
 	}
-
-	std::vector<double> t = ttest_ptr->t_test();
-	save_npy(options.t_test_filename, t);
-
-	if (options.save_traces)
+	for (unsigned int i = 0; i < 4; ++i)
 	{
-		trace_file_fixed.close();
-		trace_file_random.close();
+		inputs[i] = rows[i];
 	}
+	sec_rectangle_v04_wrapper(rnd_gen_uint32, cpu, rows, rk);
+}
 
-	if (ttest_ptr != nullptr)
-	{
-		delete ttest_ptr;
-	}
+
+const Sec_algo sec_algo =
+{
+	"sec_rectangle_v04",
+	4,
+	load,
+	measure
+};
+
+void t_test_sec_algo(Options &options)
+{
+	Campaign campaign(options, sec_algo);
+
+	campaign.run();
 }
@@ -37,10 +37,8 @@
 #include <iostream>
 #include <fstream>
 #include <unistd.h>
-#include <progress_bar.h>
 #include "cpu.h"
-#include "t_test.h"
-#include "npy.h"
+#include "campaign.h"
 #include "options.h"
 #include "sim_sec_algo.h"
 
@@ -141,23 +139,13 @@ void check_sec_algo(Options &options)
 }
 
 
-void t_test_sec_algo(Options &options)
+void measure(std::mt19937 &rnd_gen_uint32, Cpu *cpu, Input_class input_class, uint32_t *inputs)
 {
-	Cpu cpu(options);
-	Ttest *ttest_ptr = nullptr;
-	std::random_device random_dev;
-	std::mt19937 rnd_gen_uint32(random_dev());
-	std::vector<unsigned int> trace;
-	std::ofstream trace_file_fixed;
-	std::ofstream trace_file_random;
-
-	load(&cpu);
-	cpu.reset();
 //	const uint32_t l_fixed = 0x656b696c;
 //	const uint32_t r_fixed = 0x20646e75;
-    const uint32_t l_fixed = 0x44c8fc20;
-    const uint32_t r_fixed = 0xb9dfa07a;
-	uint32_t rk[] = {
+    static const uint32_t l_fixed = 0x44c8fc20;
+    static const uint32_t r_fixed = 0xb9dfa07a;
+	static uint32_t rk[] = {
 		0x03020100, 0x0b0a0908, 0x13121110, 0x1b1a1918,
 		0x70a011c3, 0xb770ec49, 0x57e3e835, 0xd397bc42,
 		0x94dcf81f, 0xbf4b5f18, 0x8e5dabb9, 0xdbf4a863,
@@ -170,58 +158,41 @@ void t_test_sec_algo(Options &options)
 		0xd0e929e8, 0x8fe484b9, 0x42054bee, 0xaf77bae2,
 		0x18199c02, 0x719e3f1c, 0x0c1cf793, 0x15df4696
 	};
+	uint32_t l;
+	uint32_t r;
 
-	if (options.save_traces)
-	{
-		std::string filename_fixed = "trace_fixed_n_measure_" + std::to_string(options.n_measure) + ".bin";
-		trace_file_fixed.open(filename_fixed, std::ios::out | std::ios::binary);
-		std::string filename_random = "trace_random_n_measure_" + std::to_string(options.n_measure) + ".bin";
-		trace_file_random.open(filename_random, std::ios::out | std::ios::binary);
-	}
-
-	Progress_bar progress_bar(options.n_measure, std::cout, "Simulating sec_simon_v02 ...\n");
-	for (unsigned long int measure_idx = 0; measure_idx < options.n_measure; ++measure_idx)
+	if (input_class == INPUT_FIXED)
 	{
-		uint32_t l;
-		uint32_t r;
-		/* fixed */
 		l = l_fixed;
 		r = r_fixed;
-		sec_simon_v02_wrapper(rnd_gen_uint32, &cpu, &l, &r, rk);
-		trace = cpu.get_pwr_trace();
-		if (measure_idx == 0)
-		{
-			ttest_ptr = new Ttest(trace.size());
-		}
-		ttest_ptr->update1(trace);
-		if (options.save_traces)
-		{
-			trace_file_fixed.write((char *)trace.data(), sizeof(unsigned int)*trace.size());
-		}
-		/* random */
+	}
+	else if (input_class == INPUT_FIXED_2)
+	{
+		l = ~l_fixed;
+		r = ~r_fixed;
+	}
+	else
+	{
 		l = rnd_gen_uint32();
 		r = rnd_gen_uint32();
-		sec_simon_v02_wrapper(rnd_gen_uint32, &cpu, &l, &r, rk);
-		trace = cpu.get_pwr_trace();
-		ttest_ptr->update2(trace);
-		if (options.save_traces)
-		{
-			trace_file_random.write((char *)trace.data(), sizeof(unsigned int)*trace.size());
-		}
-		++progress_bar;
 	}
+	inputs[0] = l;
+	inputs[1] = r;
+	sec_simon_v02_wrapper(rnd_gen_uint32, cpu, &l, &r, rk);
+}
 
-	std::vector<double> t = ttest_ptr->t_test();
-	save_npy(options.t_test_filename, t);
 
-	if (options.save_traces)
-	{
-		trace_file_fixed.close();
-		trace_file_random.close();
-	}
+const Sec_algo sec_algo =
+{
+	"sec_simon_v02",
+	2,
+	load,
+	measure
+};
 
-	if (ttest_ptr != nullptr)
-	{
-		delete ttest_ptr;
-	}
+void t_test_sec_algo(Options &options)
+{
+	Campaign campaign(options, sec_algo);
+
+	campaign.run();
 }
@@ -37,10 +37,8 @@
 #include <iostream>
 #include <fstream>
 #include <unistd.h>
-#include <progress_bar.h>
 #include "cpu.h"
-#include "t_test.h"
-#include "npy.h"
+#include "campaign.h"
 #include "options.h"
 #include "sim_sec_algo.h"
 
@@ -135,21 +133,11 @@ void check_sec_algo(Options &options)
 }
 
 
-void t_test_sec_algo(Options &options)
+void measure(std::mt19937 &rnd_gen_uint32, Cpu *cpu, Input_class input_class, uint32_t *inputs)
 {
-	Cpu cpu(options);
-	Ttest *ttest_ptr = nullptr;
-	std::random_device random_dev;
-	std::mt19937 rnd_gen_uint32(random_dev());
-	std::vector<unsigned int> trace;
-	std::ofstream trace_file_fixed;
-	std::ofstream trace_file_random;
-
-	load(&cpu);
-	cpu.reset();
-	uint32_t l_fixed = 0x3b726574;
-	uint32_t r_fixed = 0x7475432d;
-	uint32_t rk[] = {
+	static uint32_t l_fixed = 0x3b726574;
+	static uint32_t r_fixed = 0x7475432d;
+	static uint32_t rk[] = {
 		0x03020100, 0x131d0309, 0xbbd80d53, 0x0d334df3,
 		0x7fa43565, 0x67e6ce55, 0xe98cb3d2, 0xaac76cbd,
 		0x7f5951c8, 0x03fa82c2, 0x313533ad, 0xdff70882,
@@ -158,58 +146,69 @@ void t_test_sec_algo(Options &options)
 		0x6a1ab912, 0x10bc6bca, 0x6057dd32, 0xd3c9b381,
 		0xb347813d, 0x8c113c35, 0xfe6b523a
 	};
+	uint32_t l;
+	uint32_t r;
 
-	if (options.save_traces)
+	if (input_class == INPUT_FIXED)
 	{
-		std::string filename_fixed = "trace_fixed_n_measure_" + std::to_string(options.n_measure) + ".bin";
-		trace_file_fixed.open(filename_fixed, std::ios::out | std::ios::binary);
-		std::string filename_random = "trace_random_n_measure_" + std::to_string(options.n_measure) + ".bin";
-		trace_file_random.open(filename_random, std::ios::out | std::ios::binary);
-	}
-
-	Progress_bar progress_bar(options.n_measure, std::cout, "Simulating sec_speck_v02 ...\n");
-	for (unsigned long int measure_idx = 0; measure_idx < options.n_measure; ++measure_idx)
-	{
-		uint32_t l;
-		uint32_t r;
-		/* fixed */
 		l = l_fixed;
 		r = r_fixed;
-		sec_speck_v02_wrapper(rnd_gen_uint32, &cpu, &l, &r, rk);
-		trace = cpu.get_pwr_trace();
-		if (measure_idx == 0)
-		{
-			ttest_ptr = new Ttest(trace.size());
-		}
-		ttest_ptr->update1(trace);
-		if (options.save_traces)
-		{
-			trace_file_fixed.write((char *)trace.data(), sizeof(unsigned int)*trace.size());
-		}
-		/* random */
+	}
+	else if (input_class == INPUT_FIXED_2)
+	{
+		l = ~l_fixed;
+		r = ~r_fixed;
+	}
+	else
+	{
 		l = rnd_gen_uint32();
 		r = rnd_gen_uint32();
-		sec_speck_v02_wrapper(rnd_gen_uint32, &cpu, &l, &r, rk);
-		trace = cpu.get_pwr_trace();
-		ttest_ptr->update2(trace);
-		if (options.save_traces)
-		{
-			trace_file_random.write((char *)trace.data(), sizeof(unsigned int)*trace.size());
-		}
-		++progress_bar;
 	}
+	inputs[0] = l;
+	inputs[1] = r;
+	sec_speck_v02_wrapper(rnd_gen_uint32, cpu, &l, &r, rk);
+}
 
-	std::vector<double> t = ttest_ptr->t_test();
-	save_npy(options.t_test_filename, t);
 
-	if (options.save_traces)
-	{
-		trace_file_fixed.close();
-		trace_file_random.close();
-	}
+/* CPA leakage model: Hamming weight of the low byte of the first round output
+   x1 = (ROR(l, 8) + r) ^ rk[0] for the 256 guesses of the low byte of rk[0].
+   The low byte of the sum only depends on the low bytes of its operands */
+void model(const uint32_t *inputs, unsigned int *h)
+{
+	uint32_t sum = ((inputs[0] >> 8) | (inputs[0] << 24)) + inputs[1];
 
-	if (ttest_ptr != nullptr)
+	for (unsigned int guess = 0; guess < 256; ++guess)
 	{
-		delete ttest_ptr;
+		h[guess] = __builtin_popcount((sum ^ guess) & 0xff);
 	}
 }
+
+/* SNR and MI intermediate: low byte of the first round output x1 with the
+   actual key */
+unsigned int intermediate(const uint32_t *inputs)
+{
+	uint32_t sum = ((inputs[0] >> 8) | (inputs[0] << 24)) + inputs[1];
+
+	return (sum ^ 0x03020100) & 0xff; /* rk[0] */
+}
+
+
+const Sec_algo sec_algo =
+{
+	"sec_speck_v02",
+	2,
+	load,
+	measure,
+	256,
+	0x00, /* rk[0] & 0xff */
+	model,
+	256,
+	intermediate
+};
+
+void t_test_sec_algo(Options &options)
+{
+	Campaign campaign(options, sec_algo);
+
+	campaign.run();
+}